@@ -1,22 +1,115 @@
 #include "AIController.h"
 #include "SimplexAlgorithm.h"  // Declares the Simplex class.
-#include <iostream>
+#include "Log.h"
+#include "Metrics.h"
+#include "Trace.h"
 #include <climits>
+#include <limits>
+#include <cmath>
 #include <algorithm>
 #include <unordered_map>
 #include <vector>
 
+namespace {
+    // Profit of a plan under the tableau's objective row (which holds -profit).
+    double planProfit(const std::vector<std::vector<double>>& tableau, const std::vector<double>& x) {
+        double profit = 0.0;
+        for (size_t j = 0; j < x.size(); j++)
+            profit -= tableau[0][j] * x[j];
+        return profit;
+    }
+
+    bool planFeasible(const std::vector<std::vector<double>>& tableau, const std::vector<double>& x) {
+        size_t n = x.size();
+        for (size_t j = 0; j < n; j++) {
+            if (x[j] < -1e-9)
+                return false;
+        }
+        for (size_t i = 1; i < tableau.size(); i++) {
+            double used = 0.0;
+            for (size_t j = 0; j < n; j++)
+                used += tableau[i][j] * x[j];
+            if (used > tableau[i][n] + 1e-6)
+                return false;
+        }
+        return true;
+    }
+
+    // Recipe-ratio heuristic: ranks products by profit per share of their scarcest input
+    // (the row whose right-hand side one unit uses most of), then makes each in the largest
+    // whole quantity the remaining slack allows. A second pass lets products whose
+    // ingredients were planned after them use those. Always feasible; O(products * rows).
+    std::vector<double> greedyPlan(const std::vector<std::vector<double>>& tableau) {
+        size_t rows = tableau.size();
+        size_t n = tableau[0].size() - 1;
+        std::vector<double> slack(rows, 0.0);
+        for (size_t i = 1; i < rows; i++)
+            slack[i] = tableau[i][n];
+
+        std::vector<std::pair<double, size_t>> ranked;
+        for (size_t j = 0; j < n; j++) {
+            double profit = -tableau[0][j];
+            double scarcest = 0.0;
+            bool possible = profit > 0.0;
+            for (size_t i = 1; possible && i < rows; i++) {
+                if (tableau[i][j] <= 0.0)
+                    continue;
+                if (slack[i] <= 0.0)
+                    possible = false;
+                else
+                    scarcest = std::max(scarcest, tableau[i][j] / slack[i]);
+            }
+            if (possible && scarcest > 0.0)
+                ranked.push_back({ profit / scarcest, j });
+        }
+        std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+        std::vector<double> x(n, 0.0);
+        for (int pass = 0; pass < 2; pass++) {
+            for (const auto& entry : ranked) {
+                size_t j = entry.second;
+                double quantity = std::numeric_limits<double>::max();
+                for (size_t i = 1; i < rows; i++) {
+                    if (tableau[i][j] > 0.0)
+                        quantity = std::min(quantity, std::floor(slack[i] / tableau[i][j] + 1e-9));
+                }
+                if (quantity <= 0.0 || quantity == std::numeric_limits<double>::max())
+                    continue;
+                x[j] += quantity;
+                for (size_t i = 1; i < rows; i++)
+                    slack[i] -= tableau[i][j] * quantity;
+            }
+        }
+        return x;
+    }
+}
+
+AIController::AIController(float priceEpsilon) : priceEpsilon(priceEpsilon) {}
+
+std::chrono::steady_clock::time_point AIController::planningDeadline(std::chrono::steady_clock::time_point start) const {
+    std::chrono::nanoseconds limit = std::chrono::nanoseconds::max();
+    if (budget.perFactory.count() > 0)
+        limit = budget.perFactory;
+    if (budget.perDay.count() > 0)
+        limit = std::min(limit, std::max(budget.perDay - daySpent, std::chrono::nanoseconds(0)));
+    if (limit == std::chrono::nanoseconds::max())
+        return std::chrono::steady_clock::time_point::max();
+    return start + limit;
+}
+
 void AIController::updateFactory(SimulationWorld& world, Factory& factory) {
+    METRICS_TIME(MetricPhase::AiTurn);
+    TRACE_SCOPE_ARG("AIController::updateFactory", "factory", factory.id);
     // Extract components from the world.
     Market& market = world.market;
     const std::vector<Commodity>& productCatalog = world.productCatalog;
     const std::vector<Commodity>& resourceCatalog = world.resourceCatalog;
     const std::vector<Equipment>& equipCatalog = world.equipmentCatalog;
 
-    std::cout << "\n[AI Factory " << factory.id << " Turn]\n";
+    simLog() << "\n[AI Factory " << factory.id << " Turn]\n";
 
     if (productCatalog.empty() || resourceCatalog.empty()) {
-        std::cout << "No products or resources available for production.\n";
+        simLog() << "No products or resources available for production.\n";
         return;
     }
 
@@ -31,11 +124,8 @@ void AIController::updateFactory(SimulationWorld& world, Factory& factory) {
         }
     }
 
-    // Calculate current equipment capacity: sum of output rates of all owned equipment.
-    int equipmentCapacity = 0;
-    for (const auto& equip : factory.equipment) {
-        equipmentCapacity += equip.output_rate;
-    }
+    // Current equipment capacity: sum of output rates of all owned equipment (cached by Factory).
+    int equipmentCapacity = factory.capacity;
 
     // --- Construct the Linear Program ---
     // Decision variables: production quantities for each product in productCatalog.
@@ -57,98 +147,254 @@ void AIController::updateFactory(SimulationWorld& world, Factory& factory) {
     }
     int numResourceConstraints = resourcesUsed.size();
 
-    // Total constraints: one for each resource plus one for equipment.
-    int numConstraints = numResourceConstraints + 1;
-
-    // Create the tableau: (numConstraints+1) rows and (numProducts+1) columns.
-    // Row 0: objective function. Rows 1..numResourceConstraints: resource constraints.
-    // Last row: equipment constraint.
-    std::vector<std::vector<double>> tableau;
-    tableau.resize(numConstraints + 1, std::vector<double>(numProducts + 1, 0.0));
+    // Products that are ingredients of other products (multi-level recipes), with the
+    // quantity currently held. Each gets a balance row: units consumed by other products
+    // may not exceed units held plus units produced.
+    std::unordered_map<int, int> productColumn;
+    for (int j = 0; j < numProducts; j++)
+        productColumn[productCatalog[j].id] = j;
+    std::vector<int> intermediatesUsed;
+    for (const auto& prod : productCatalog) {
+        for (const auto& req : prod.recipe) {
+            if (productColumn.count(req.first) &&
+                std::find(intermediatesUsed.begin(), intermediatesUsed.end(), req.first) == intermediatesUsed.end())
+                intermediatesUsed.push_back(req.first);
+        }
+    }
+    int numIntermediateConstraints = intermediatesUsed.size();
 
-    // Objective row: maximize total profit.
-    // For simplicity, assume profit per unit = product.price.
-    // Since our simplex code minimizes, we set coefficient = -profit.
+    // Equipment types required by at least one product: each gets a capacity row.
+    // Products whose required equipment is not owned in sufficient quantity are blocked.
+    std::vector<int> equipmentUsed;
+    std::vector<int> blockedProducts;
     for (int j = 0; j < numProducts; j++) {
-        double profit = productCatalog[j].price;
-        tableau[0][j] = -profit;
+        bool blocked = false;
+        for (const auto& req : productCatalog[j].requiredEquipment) {
+            if (std::find(equipmentUsed.begin(), equipmentUsed.end(), req.first) == equipmentUsed.end())
+                equipmentUsed.push_back(req.first);
+            if (factory.equipmentCount(req.first) < req.second)
+                blocked = true;
+        }
+        if (blocked)
+            blockedProducts.push_back(j);
     }
-    tableau[0][numProducts] = 0.0;
+    int numEquipmentTypeConstraints = equipmentUsed.size();
+    int numBlockedConstraints = blockedProducts.size();
 
-    // Resource constraints: For each used resource, sum_j (recipe requirement) * x_j <= available.
-    for (int i = 0; i < numResourceConstraints; i++) {
-        int resId = resourcesUsed[i];
-        for (int j = 0; j < numProducts; j++) {
-            // Find the requirement of resource resId for product j.
-            int reqQuantity = 0;
-            for (const auto& req : productCatalog[j].recipe) {
-                if (req.first == resId) {
-                    reqQuantity = req.second;
-                    break;
-                }
+    // The LP depends only on these inputs; when none changed since the last solve (prices
+    // within priceEpsilon of the planned ones), the previous solution is reused.
+    std::vector<int> planQuantities;
+    for (int resId : resourcesUsed)
+        planQuantities.push_back(resourceAvail[resId]);
+    for (int prodId : intermediatesUsed) {
+        int held = 0;
+        for (const auto& item : factory.inventory) {
+            if (item.first.id == prodId) {
+                held = item.second;
+                break;
             }
-            tableau[i + 1][j] = reqQuantity;
         }
-        // RHS is the available amount for resource resId.
-        tableau[i + 1][numProducts] = resourceAvail[resId];
+        planQuantities.push_back(held);
     }
+    for (int equipId : equipmentUsed)
+        planQuantities.push_back(factory.equipmentCapacity(equipId));
+    planQuantities.insert(planQuantities.end(), blockedProducts.begin(), blockedProducts.end());
+    planQuantities.push_back(equipmentCapacity);
+    std::vector<Price> planPrices;
+    for (const auto& prod : productCatalog)
+        planPrices.push_back(prod.price);
 
-    // Equipment constraint: Sum_j x_j <= equipmentCapacity.
-    int equipRow = numConstraints; // Last row.
-    for (int j = 0; j < numProducts; j++) {
-        tableau[equipRow][j] = 1;
-    }
-    tableau[equipRow][numProducts] = equipmentCapacity;
+    Plan& plan = plans[factory.id];
+    bool reuse = !plan.solution.empty() && plan.quantities == planQuantities &&
+        plan.prices.size() == planPrices.size();
+    for (size_t j = 0; reuse && j < planPrices.size(); j++)
+        reuse = std::fabs(static_cast<double>(planPrices[j] - plan.prices[j])) <= priceEpsilon * plan.prices[j];
 
-    // Solve the LP using the simplex algorithm.
-    Simplex simplex(tableau);
-    bool solved = simplex.solve();
-    if (!solved) {
-        std::cout << "Simplex algorithm failed to find an optimal solution.\n";
-        return;
+    std::vector<double> solution;
+    if (reuse) {
+        METRICS_COUNT(MetricCounter::PlansReused, 1);
+        simLog() << "Production inputs unchanged; reusing the previous plan.\n";
+        solution = plan.solution;
     }
-    std::vector<double> solution = simplex.getSolution();
+    else {
+        // Total constraints: one for each resource, one for each intermediate product, one for each
+        // equipment type, one for each blocked product, plus one for overall equipment capacity.
+        int numConstraints = numResourceConstraints + numIntermediateConstraints +
+            numEquipmentTypeConstraints + numBlockedConstraints + 1;
 
-    // --- Process the Production Decision ---
-    // For each product, the solution gives the production quantity.
-    for (int j = 0; j < numProducts; j++) {
-        int productionQty = static_cast<int>(solution[j] + 0.001); // Round down.
-        if (productionQty > 0) {
-            const Commodity& prod = productCatalog[j];
-            // Deduct resources from inventory according to the recipe.
-            for (const auto& req : prod.recipe) {
-                int resId = req.first;
-                int totalRequired = productionQty * req.second;
-                for (auto& item : factory.inventory) {
-                    if (item.first.id == resId && item.first.type == CommodityType::Resource) {
-                        item.second -= totalRequired;
+        // Create the tableau: (numConstraints+1) rows and (numProducts+1) columns.
+        // Row 0: objective function. Rows 1..numResourceConstraints: resource constraints.
+        // Next numIntermediateConstraints rows: intermediate product balances.
+        // Then per-equipment-type capacity rows and blocked-product rows.
+        // Last row: equipment constraint.
+        std::vector<std::vector<double>> tableau;
+        tableau.resize(numConstraints + 1, std::vector<double>(numProducts + 1, 0.0));
+
+        // Objective row: maximize net revenue. A unit of product j earns its price less the
+        // price of the intermediate products it consumes, so units made only to be used
+        // downstream are not counted as sold: sum_j c_j x_j = sum_k price_k (x_k - internal use).
+        // Since our simplex code minimizes, we set coefficient = -profit.
+        for (int j = 0; j < numProducts; j++) {
+            double profit = priceToDouble(productCatalog[j].price);
+            for (const auto& req : productCatalog[j].recipe) {
+                auto it = productColumn.find(req.first);
+                if (it != productColumn.end())
+                    profit -= req.second * priceToDouble(productCatalog[it->second].price);
+            }
+            tableau[0][j] = -profit;
+        }
+        tableau[0][numProducts] = 0.0;
+
+        // Resource constraints: For each used resource, sum_j (recipe requirement) * x_j <= available.
+        for (int i = 0; i < numResourceConstraints; i++) {
+            int resId = resourcesUsed[i];
+            for (int j = 0; j < numProducts; j++) {
+                // Find the requirement of resource resId for product j.
+                int reqQuantity = 0;
+                for (const auto& req : productCatalog[j].recipe) {
+                    if (req.first == resId) {
+                        reqQuantity = req.second;
                         break;
                     }
                 }
+                tableau[i + 1][j] = reqQuantity;
             }
-            // Add produced product to inventory.
-            bool found = false;
-            for (auto& item : factory.inventory) {
-                if (item.first.id == prod.id && item.first.type == CommodityType::Product) {
-                    item.second += productionQty;
-                    found = true;
+            // RHS is the available amount for resource resId.
+            tableau[i + 1][numProducts] = resourceAvail[resId];
+        }
+
+        // Intermediate constraints: sum_j (recipe requirement) * x_j - x_k <= held_k.
+        for (int i = 0; i < numIntermediateConstraints; i++) {
+            int row = numResourceConstraints + i + 1;
+            int prodId = intermediatesUsed[i];
+            for (int j = 0; j < numProducts; j++) {
+                for (const auto& req : productCatalog[j].recipe) {
+                    if (req.first == prodId) {
+                        tableau[row][j] = req.second;
+                        break;
+                    }
+                }
+            }
+            tableau[row][productColumn[prodId]] -= 1;
+            int held = 0;
+            for (const auto& item : factory.inventory) {
+                if (item.first.id == prodId) {
+                    held = item.second;
                     break;
                 }
             }
-            if (!found) {
-                Commodity newProd = prod; // Copy product definition.
-                factory.inventory.push_back({ newProd, productionQty });
+            tableau[row][numProducts] = held;
+        }
+
+        // Per-type capacity: sum over products requiring type e of x_j <= count_e * output_rate_e.
+        int firstEquipmentTypeRow = numResourceConstraints + numIntermediateConstraints + 1;
+        for (int i = 0; i < numEquipmentTypeConstraints; i++) {
+            int row = firstEquipmentTypeRow + i;
+            int equipId = equipmentUsed[i];
+            for (int j = 0; j < numProducts; j++) {
+                for (const auto& req : productCatalog[j].requiredEquipment) {
+                    if (req.first == equipId) {
+                        tableau[row][j] = 1;
+                        break;
+                    }
+                }
+            }
+            tableau[row][numProducts] = factory.equipmentCapacity(equipId);
+        }
+
+        // Blocked products: x_j <= 0.
+        for (int i = 0; i < numBlockedConstraints; i++) {
+            int row = firstEquipmentTypeRow + numEquipmentTypeConstraints + i;
+            tableau[row][blockedProducts[i]] = 1;
+            tableau[row][numProducts] = 0;
+        }
+
+        // Equipment constraint: Sum_j x_j <= equipmentCapacity.
+        int equipRow = numConstraints; // Last row.
+        for (int j = 0; j < numProducts; j++) {
+            tableau[equipRow][j] = 1;
+        }
+        tableau[equipRow][numProducts] = equipmentCapacity;
+
+        // Solve the LP using the simplex algorithm, within the planning budget.
+        auto solveStart = std::chrono::steady_clock::now();
+        Simplex simplex(tableau);
+        SolveStatus status = simplex.solve(planningDeadline(solveStart));
+        if (budget.perDay.count() > 0)
+            daySpent += std::chrono::steady_clock::now() - solveStart;
+        if (status == SolveStatus::Unbounded) {
+            simLog() << "Simplex algorithm failed to find an optimal solution.\n";
+            plan.solution.clear();
+            return;
+        }
+        if (status == SolveStatus::TimedOut) {
+            // Act on the better feasible plan at hand; don't keep it, so the next turn
+            // plans again.
+            METRICS_COUNT(MetricCounter::PlanBudgetHits, 1);
+            solution = greedyPlan(tableau);
+            std::vector<double> partial = simplex.getSolution();
+            if (planFeasible(tableau, partial) && planProfit(tableau, partial) > planProfit(tableau, solution))
+                solution = partial;
+            simLog() << "Planning budget used up; acting on a heuristic plan.\n";
+            plan.solution.clear();
+        }
+        else {
+            solution = simplex.getSolution();
+            plan.quantities = planQuantities;
+            plan.prices = planPrices;
+            plan.solution = solution;
+        }
+    }
+
+    // Planned units of each product consumed by this factory's own production.
+    std::vector<int> plannedQty(numProducts);
+    std::vector<int> internalUse(numProducts, 0);
+    for (int j = 0; j < numProducts; j++)
+        plannedQty[j] = static_cast<int>(solution[j] + 0.001); // Round down.
+    for (int j = 0; j < numProducts; j++) {
+        for (const auto& req : productCatalog[j].recipe) {
+            auto it = productColumn.find(req.first);
+            if (it != productColumn.end())
+                internalUse[it->second] += plannedQty[j] * req.second;
+        }
+    }
+
+    // --- Process the Production Decision ---
+    // Produce in recipe order so intermediate products exist before they are consumed.
+    std::vector<int> productionOrder;
+    for (int prodId : world.productionGraph.topologicalOrder()) {
+        auto it = productColumn.find(prodId);
+        if (it != productColumn.end())
+            productionOrder.push_back(it->second);
+    }
+    if (productionOrder.size() != productCatalog.size()) {
+        productionOrder.clear();
+        for (int j = 0; j < numProducts; j++)
+            productionOrder.push_back(j);
+    }
+    for (int j : productionOrder) {
+        const Commodity& prod = productCatalog[j];
+        // Rounding the LP solution down can leave an intermediate a unit short; the engine
+        // never consumes more of an ingredient than is actually held.
+        int productionQty = world.production.produce(factory, prod, plannedQty[j]);
+        if (productionQty > 0) {
+            // Place a sell order for the units not needed by downstream recipes, never
+            // asking less than it costs to make them.
+            int listQty = productionQty - internalUse[j];
+            if (listQty > 0) {
+                Price askPrice = std::max(prod.price, world.productionGraph.marginalCost(prod.id));
+                market.placeSellOrder(prod.id, listQty, askPrice, factory.id);
             }
-            // Place a sell order for the produced product.
-            market.placeSellOrder(prod.id, productionQty, prod.price, factory.id);
-            std::cout << "AI Factory " << factory.id << " produced and listed "
-                << productionQty << " units of " << prod.name << ".\n";
+            simLog() << "AI Factory " << factory.id << " produced " << productionQty << " units of "
+                << prod.name << " and listed " << std::max(listQty, 0) << ".\n";
         }
     }
 
     // --- Resource Replenishment ---
     // For each resource used in the LP, if current inventory is less than the target (the available amount used in LP),
-    // then buy exactly the difference.
+    // then buy exactly the difference. The shortfalls go out as one proportional basket, so
+    // the inputs arrive in the ratio they were used and the book is walked once per turn.
+    std::vector<BasketLeg> legs;
     for (const auto& res : resourceCatalog) {
         if (resourceAvail.find(res.id) == resourceAvail.end())
             continue;
@@ -160,26 +406,52 @@ void AIController::updateFactory(SimulationWorld& world, Factory& factory) {
                 break;
             }
         }
-        if (current < target) {
-            int amountToBuy = target - current;
-            float buyPrice = res.price * 1.05f;
-            market.placeBuyOrder(res.id, amountToBuy, buyPrice, factory.id);
-            std::cout << "AI Factory " << factory.id << " placed BUY order for resource "
-                << res.id << " for quantity " << amountToBuy << ".\n";
+        if (current < target)
+            legs.push_back({ res.id, target - current, scalePrice(res.price, 105, 100), 0 });
+    }
+    if (!legs.empty()) {
+        market.placeBasketOrder(legs, BasketFill::Proportional, factory.id);
+        for (const auto& leg : legs) {
+            simLog() << "AI Factory " << factory.id << " bought " << leg.filled << " of " << leg.amount
+                << " units of resource " << leg.productId << ".\n";
         }
     }
 
     // --- Equipment Upgrade ---
-    // If the current equipment capacity is lower than the total production planned,
-    // determine how much additional capacity is needed.
+    // Production is held back by equipment when a product lacks a required type, when a
+    // type's capacity is fully used, or when overall capacity is. Collect the types that
+    // would relieve that and buy one unit of the cheapest affordable one.
+    std::vector<int> upgradeCandidates;
+    auto addCandidate = [&](int equipId) {
+        if (std::find(upgradeCandidates.begin(), upgradeCandidates.end(), equipId) == upgradeCandidates.end())
+            upgradeCandidates.push_back(equipId);
+    };
+    for (int j : blockedProducts) {
+        for (const auto& req : productCatalog[j].requiredEquipment) {
+            if (factory.equipmentCount(req.first) < req.second)
+                addCandidate(req.first);
+        }
+    }
     int totalProduction = 0;
     for (int j = 0; j < numProducts; j++) {
-        totalProduction += static_cast<int>(solution[j] + 0.001);
+        totalProduction += plannedQty[j];
     }
-    if (equipmentCapacity < totalProduction) {
-        // Determine additional capacity needed.
-        int neededCapacity = totalProduction - equipmentCapacity;
-        // Evaluate each equipment option for additional capacity per cost.
+    for (int equipId : equipmentUsed) {
+        int typeCapacity = factory.equipmentCapacity(equipId);
+        int typeUsage = 0;
+        for (int j = 0; j < numProducts; j++) {
+            for (const auto& req : productCatalog[j].requiredEquipment) {
+                if (req.first == equipId) {
+                    typeUsage += plannedQty[j];
+                    break;
+                }
+            }
+        }
+        if (typeCapacity > 0 && typeUsage >= typeCapacity)
+            addCandidate(equipId);
+    }
+    if (equipmentCapacity > 0 && totalProduction >= equipmentCapacity) {
+        // Overall capacity is the limit: the best output per cost helps most.
         const Equipment* bestEquip = nullptr;
         double bestRatio = 0.0; // ratio = output_rate / price.
         for (const auto& equip : equipCatalog) {
@@ -189,14 +461,25 @@ void AIController::updateFactory(SimulationWorld& world, Factory& factory) {
                 bestEquip = &equip;
             }
         }
-        if (bestEquip && factory.balance >= bestEquip->price) {
-            factory.balance -= bestEquip->price;
-            factory.equipment.push_back(*bestEquip);
-            std::cout << "AI Factory " << factory.id << " purchased Equipment " << bestEquip->id
-                << " (Output Rate: " << bestEquip->output_rate << ").\n";
+        if (bestEquip)
+            addCandidate(bestEquip->id);
+    }
+
+    if (!upgradeCandidates.empty()) {
+        const Equipment* cheapest = nullptr;
+        for (const auto& equip : equipCatalog) {
+            if (std::find(upgradeCandidates.begin(), upgradeCandidates.end(), equip.id) != upgradeCandidates.end() &&
+                (!cheapest || equip.price < cheapest->price))
+                cheapest = &equip;
+        }
+        if (cheapest && factory.balance >= cheapest->price) {
+            factory.balance -= cheapest->price;
+            factory.addEquipment(*cheapest, 1);
+            simLog() << "AI Factory " << factory.id << " purchased Equipment " << cheapest->id
+                << " (Output Rate: " << cheapest->output_rate << ").\n";
         }
         else {
-            std::cout << "AI Factory " << factory.id << " cannot afford additional equipment upgrade.\n";
+            simLog() << "AI Factory " << factory.id << " cannot afford additional equipment upgrade.\n";
         }
     }
 }
@@ -1,9 +1,49 @@
 #pragma once
 #include "Initialization.h"  // Provides SimulationWorld, Factory, Market, Commodity, Equipment
+#include <chrono>
+#include <unordered_map>
 #include <vector>
 
+// Wall-clock limits on LP planning; zero means unlimited. When a factory's limit (or what
+// is left of the day's) runs out, the factory acts on the better of a greedy plan and
+// wherever the Simplex has got to. Any limit makes runs timing dependent.
+struct PlanningBudget {
+    std::chrono::nanoseconds perFactory{ 0 };   // One factory's Simplex solve.
+    std::chrono::nanoseconds perDay{ 0 };       // All solves between two beginDay() calls.
+};
+
 class AIController {
 public:
+    // A factory's production plan (the LP solution) is reused while its inventory and
+    // equipment are unchanged and every product price is within priceEpsilon (relative)
+    // of the price it was planned at.
+    explicit AIController(float priceEpsilon = 0.01f);
+
     // Updated function: update an individual AI factory using the full simulation world.
     void updateFactory(SimulationWorld &world, Factory &factory);
+
+    void setPriceEpsilon(float epsilon) { priceEpsilon = epsilon; }
+    float getPriceEpsilon() const { return priceEpsilon; }
+
+    void setPlanningBudget(const PlanningBudget& limits) { budget = limits; }
+    const PlanningBudget& getPlanningBudget() const { return budget; }
+
+    // Starts a new day's planning budget.
+    void beginDay() { daySpent = std::chrono::nanoseconds(0); }
+
+private:
+    // Inputs the last LP was built from and its solution.
+    struct Plan {
+        std::vector<int> quantities;  // Resource and intermediate stock, equipment capacities, blocked products.
+        std::vector<Price> prices;    // Product prices (the LP objective).
+        std::vector<double> solution;
+    };
+
+    // When the current solve must stop (time_point::max() without a budget).
+    std::chrono::steady_clock::time_point planningDeadline(std::chrono::steady_clock::time_point start) const;
+
+    float priceEpsilon;
+    std::unordered_map<int, Plan> plans;  // By factory id.
+    PlanningBudget budget;
+    std::chrono::nanoseconds daySpent{ 0 };
 };
@@ -0,0 +1,193 @@
+#include "AgentCoroutines.h"
+#include "Initialization.h"
+#include "Metrics.h"
+#include <cassert>
+
+AgentTask& AgentTask::operator=(AgentTask&& other) noexcept {
+    if (this != &other) {
+        if (handle)
+            handle.destroy();
+        handle = other.handle;
+        other.handle = nullptr;
+    }
+    return *this;
+}
+
+AgentTask::~AgentTask() {
+    // Only a task that was never spawned still owns its frame.
+    if (handle)
+        handle.destroy();
+}
+
+AgentScheduler::AgentScheduler(SimulationWorld& world) : world(world) {
+    world.market.agentEvents = this;
+}
+
+AgentScheduler::~AgentScheduler() {
+    if (world.market.agentEvents == this)
+        world.market.agentEvents = nullptr;
+    for (void* frame : live)
+        std::coroutine_handle<>::from_address(frame).destroy();
+}
+
+void AgentScheduler::spawn(AgentTask task) {
+    std::coroutine_handle<> handle = task.handle;
+    task.handle = nullptr;
+    live.insert(handle.address());
+    handle.resume();
+    finishIfDone(handle);
+}
+
+void AgentScheduler::finishIfDone(std::coroutine_handle<> handle) {
+    if (!handle.done())
+        return;
+    live.erase(handle.address());
+    handle.destroy();
+}
+
+bool AgentScheduler::cancel(int orderId, int ownerId) {
+    return world.market.removeOrder(orderId, ownerId);
+}
+
+Price AgentScheduler::currentPrice(int commodityId) const {
+    return commodityPrice(world, commodityId);
+}
+
+// --- Awaitables ---
+
+bool AgentScheduler::OrderAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    Market& market = scheduler.world.market;
+    // Register under the id the order is about to get, so fills on entry are counted too.
+    int orderId = market.nextOrderId;
+    waiter.handle = handle;
+    waiter.fill.orderId = orderId;
+    scheduler.fillWaiters[orderId] = &waiter;
+    int placed = type == OrderType::BUY
+        ? market.placeBuyOrder(productId, amount, price, ownerId)
+        : market.placeSellOrder(productId, amount, price, ownerId);
+    assert(placed == orderId);
+    (void)placed;
+    if (waiter.fill.filled > 0) {
+        scheduler.fillWaiters.erase(orderId);
+        return false;   // Traded on entry: carry on without suspending.
+    }
+    waiter.suspended = true;
+    return true;
+}
+
+OrderFill AgentScheduler::OrderAwaiter::await_resume() {
+    scheduler.fillWaiters.erase(waiter.fill.orderId);
+    return waiter.fill;
+}
+
+void AgentScheduler::FillAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    waiter.handle = handle;
+    waiter.suspended = true;
+    waiter.fill.orderId = orderId;
+    scheduler.fillWaiters[orderId] = &waiter;
+}
+
+OrderFill AgentScheduler::FillAwaiter::await_resume() {
+    scheduler.fillWaiters.erase(orderId);
+    return waiter.fill;
+}
+
+bool AgentScheduler::PriceAwaiter::await_ready() const {
+    Price price = scheduler.currentPrice(commodityId);
+    return above ? price >= threshold : price <= threshold;
+}
+
+void AgentScheduler::PriceAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    if (above)
+        scheduler.risingWaiters[commodityId].emplace(threshold, handle);
+    else
+        scheduler.fallingWaiters[commodityId].emplace(threshold, handle);
+}
+
+Price AgentScheduler::PriceAwaiter::await_resume() const {
+    return scheduler.currentPrice(commodityId);
+}
+
+// --- Driving ---
+
+void AgentScheduler::markFilled(int orderId, const Trade& trade) {
+    auto it = fillWaiters.find(orderId);
+    if (it == fillWaiters.end())
+        return;
+    Waiter& waiter = *it->second;
+    waiter.fill.filled += trade.amount;
+    waiter.fill.notional += trade.price * trade.amount;
+    if (waiter.suspended && !waiter.queued) {
+        waiter.queued = true;
+        ready.push_back(waiter.handle);
+    }
+}
+
+void AgentScheduler::onTrade(const Trade& trade) {
+    if (fillWaiters.empty())
+        return;
+    markFilled(trade.buyOrderId, trade);
+    markFilled(trade.sellOrderId, trade);
+}
+
+void AgentScheduler::closeDay() {
+    ready.insert(ready.end(), dayWaiters.begin(), dayWaiters.end());
+    dayWaiters.clear();
+
+    // Both maps are ordered so that the released waiters form a prefix.
+    for (auto it = risingWaiters.begin(); it != risingWaiters.end();) {
+        auto& waiting = it->second;
+        auto end = waiting.upper_bound(currentPrice(it->first));
+        for (auto w = waiting.begin(); w != end; ++w)
+            ready.push_back(w->second);
+        waiting.erase(waiting.begin(), end);
+        it = waiting.empty() ? risingWaiters.erase(it) : std::next(it);
+    }
+    for (auto it = fallingWaiters.begin(); it != fallingWaiters.end();) {
+        auto& waiting = it->second;
+        auto end = waiting.upper_bound(currentPrice(it->first));
+        for (auto w = waiting.begin(); w != end; ++w)
+            ready.push_back(w->second);
+        waiting.erase(waiting.begin(), end);
+        it = waiting.empty() ? fallingWaiters.erase(it) : std::next(it);
+    }
+}
+
+void AgentScheduler::runReady() {
+    // Agents resumed here may wake others (by trading with them); those go into the next
+    // batch.
+    while (!ready.empty()) {
+        running.swap(ready);
+        for (std::coroutine_handle<> handle : running) {
+            handle.resume();
+            finishIfDone(handle);
+        }
+        METRICS_COUNT(MetricCounter::AgentResumes, running.size());
+        running.clear();
+    }
+}
+
+// --- Example agent ---
+
+AgentTask dipTrader(AgentScheduler& scheduler, int ownerId, int commodityId, int lot,
+                    int dipPercent, int profitPercent) {
+    while (true) {
+        Price reference = scheduler.currentPrice(commodityId);
+        if (reference <= 0)
+            co_return;
+
+        Price entry = co_await scheduler.priceAtMost(commodityId, scalePrice(reference, 100 - dipPercent, 100));
+        OrderFill bought = co_await scheduler.buy(commodityId, lot, entry, ownerId);
+        scheduler.cancel(bought.orderId, ownerId);   // Keep what filled first, drop the rest.
+
+        int position = bought.filled;
+        Price target = scalePrice(bought.notional / position, 100 + profitPercent, 100);
+        co_await scheduler.priceAtLeast(commodityId, target);
+        OrderFill sold = co_await scheduler.sell(commodityId, position, target, ownerId);
+        while (sold.filled < position) {
+            OrderFill more = co_await scheduler.fill(sold.orderId);
+            sold.filled += more.filled;
+            sold.notional += more.notional;
+        }
+    }
+}
@@ -0,0 +1,195 @@
+#pragma once
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "Market.h"
+
+struct SimulationWorld;
+class AgentScheduler;
+
+// A coroutine agent: a function returning AgentTask that co_awaits the events below on an
+// AgentScheduler. While it waits, the agent is just its coroutine frame (its locals),
+// parked in the scheduler's tables under the event it waits for, so millions of waiting
+// agents cost no threads and no polling of the book.
+class AgentTask {
+public:
+    struct promise_type {
+        AgentTask get_return_object() {
+            return AgentTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        // Agents start when spawned, not when called.
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        // The scheduler frees finished frames.
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    AgentTask(AgentTask&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+    AgentTask& operator=(AgentTask&& other) noexcept;
+    AgentTask(const AgentTask&) = delete;
+    AgentTask& operator=(const AgentTask&) = delete;
+    ~AgentTask();
+
+private:
+    friend class AgentScheduler;
+    explicit AgentTask(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// What an order did between being placed (or awaited) and its agent resuming.
+struct OrderFill {
+    int orderId = 0;
+    int filled = 0;         // Units traded.
+    Price notional = 0;     // Sum of price * amount over those trades.
+};
+
+// Resumes coroutine agents when the events they wait for happen:
+// - fills: Market reports every trade through onTrade() (see Market::agentEvents);
+// - prices and days: the owner calls closeDay() after each end-of-day price update.
+// Agents are resumed from runReady(), never from inside the Market, so an agent may
+// trade freely when it wakes. EventSimulation owns one and drives it.
+class AgentScheduler {
+public:
+    explicit AgentScheduler(SimulationWorld& world);
+    ~AgentScheduler();
+
+    AgentScheduler(const AgentScheduler&) = delete;
+    AgentScheduler& operator=(const AgentScheduler&) = delete;
+
+    // Takes ownership of an agent and runs it to its first suspension.
+    void spawn(AgentTask task);
+
+    // Number of agents that have not finished.
+    size_t liveCount() const { return live.size(); }
+
+    // --- Awaitables ---
+
+    struct Waiter {
+        std::coroutine_handle<> handle;
+        bool suspended = false;
+        bool queued = false;
+        OrderFill fill;
+    };
+
+    // co_await scheduler.buy(...) places a BUY order and resumes at its first fill (at
+    // once if it traded on entry) with everything it traded until then. An order that
+    // never trades keeps its agent waiting; cancel it from another agent if needed.
+    class OrderAwaiter {
+    public:
+        OrderAwaiter(AgentScheduler& scheduler, OrderType type, int productId, int amount, Price price, int ownerId)
+            : scheduler(scheduler), type(type), productId(productId), amount(amount), price(price), ownerId(ownerId) {}
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle);
+        OrderFill await_resume();
+
+    private:
+        AgentScheduler& scheduler;
+        OrderType type;
+        int productId;
+        int amount;
+        Price price;
+        int ownerId;
+        Waiter waiter;
+    };
+
+    OrderAwaiter buy(int productId, int amount, Price maxPrice, int ownerId) {
+        return OrderAwaiter(*this, OrderType::BUY, productId, amount, maxPrice, ownerId);
+    }
+    OrderAwaiter sell(int productId, int amount, Price price, int ownerId) {
+        return OrderAwaiter(*this, OrderType::SELL, productId, amount, price, ownerId);
+    }
+
+    // co_await scheduler.fill(orderId) resumes at the next fill of an order that is still
+    // resting (e.g. the remainder after a partial fill).
+    class FillAwaiter {
+    public:
+        FillAwaiter(AgentScheduler& scheduler, int orderId) : scheduler(scheduler), orderId(orderId) {}
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle);
+        OrderFill await_resume();
+
+    private:
+        AgentScheduler& scheduler;
+        int orderId;
+        Waiter waiter;
+    };
+
+    FillAwaiter fill(int orderId) { return FillAwaiter(*this, orderId); }
+
+    // Cancels a resting order. An agent awaiting its fills is not woken.
+    bool cancel(int orderId, int ownerId);
+
+    // co_await scheduler.priceAtMost(id, p) / priceAtLeast(id, p) resumes (with the price)
+    // at the first end of day where the commodity's price has reached the threshold, or
+    // at once if it already has.
+    class PriceAwaiter {
+    public:
+        PriceAwaiter(AgentScheduler& scheduler, int commodityId, Price threshold, bool above)
+            : scheduler(scheduler), commodityId(commodityId), threshold(threshold), above(above) {}
+        bool await_ready() const;
+        void await_suspend(std::coroutine_handle<> handle);
+        Price await_resume() const;
+
+    private:
+        AgentScheduler& scheduler;
+        int commodityId;
+        Price threshold;
+        bool above;
+    };
+
+    PriceAwaiter priceAtMost(int commodityId, Price threshold) { return PriceAwaiter(*this, commodityId, threshold, false); }
+    PriceAwaiter priceAtLeast(int commodityId, Price threshold) { return PriceAwaiter(*this, commodityId, threshold, true); }
+
+    // co_await scheduler.nextDay() resumes after the next end-of-day price update.
+    struct DayAwaiter {
+        AgentScheduler& scheduler;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { scheduler.dayWaiters.push_back(handle); }
+        void await_resume() const noexcept {}
+    };
+
+    DayAwaiter nextDay() { return DayAwaiter{ *this }; }
+
+    // --- Driving ---
+
+    // Called by Market for every trade. Only queues the waiting agents.
+    void onTrade(const Trade& trade);
+
+    // Queues the agents waiting for the day to end and those whose price thresholds the
+    // new prices have reached. Call after the end-of-day price update.
+    void closeDay();
+
+    // Resumes queued agents (and any they wake in turn) until none are left.
+    void runReady();
+
+    // Latest price of a commodity (catalog), or 0 if unknown.
+    Price currentPrice(int commodityId) const;
+
+private:
+    void markFilled(int orderId, const Trade& trade);
+    void finishIfDone(std::coroutine_handle<> handle);
+
+    SimulationWorld& world;
+    std::unordered_set<void*> live;                      // Frames of unfinished agents.
+    std::vector<std::coroutine_handle<>> ready;
+    std::vector<std::coroutine_handle<>> running;        // The batch runReady() is resuming.
+    std::vector<std::coroutine_handle<>> dayWaiters;
+    std::unordered_map<int, Waiter*> fillWaiters;        // By order id.
+    // Per commodity, by threshold; reaching a threshold releases everything before it.
+    std::unordered_map<int, std::multimap<Price, std::coroutine_handle<>>> risingWaiters;
+    std::unordered_map<int, std::multimap<Price, std::coroutine_handle<>, std::greater<Price>>> fallingWaiters;
+};
+
+// Example agent: an outside trader in one commodity. It waits until the price has
+// dipped 'dipPercent' below where it started, buys 'lot' units, waits for the price to
+// recover by 'profitPercent' over what it paid and sells what it got, then starts again
+// from the new price. It keeps its own position; the factories are not involved.
+AgentTask dipTrader(AgentScheduler& scheduler, int ownerId, int commodityId, int lot,
+                    int dipPercent, int profitPercent);
@@ -0,0 +1,144 @@
+#include "AgentStrategies.h"
+#include "Log.h"
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+
+namespace {
+    const int QUOTE_SIZE = 10;          // Units on each side of a market maker's quote.
+    const int MAX_RANDOM_AMOUNT = 20;
+}
+
+void GreedyProducer::act(SimulationWorld& world, Factory& factory, State&) {
+    const std::vector<Commodity>& products = world.productCatalog;
+    world.production.maxProducible(factory, units);
+    int best = -1;
+    Price bestProfit = 0;
+    for (size_t j = 0; j < products.size(); j++) {
+        if (units[j] <= 0)
+            continue;
+        Price profit = (products[j].price - world.productionGraph.marginalCost(products[j].id)) * units[j];
+        if (profit > bestProfit) {
+            best = static_cast<int>(j);
+            bestProfit = profit;
+        }
+    }
+    if (best < 0) {
+        simLog() << "AI Factory " << factory.id << " (greedy) has nothing profitable to make.\n";
+        return;
+    }
+
+    const Commodity& prod = products[best];
+    int made = world.production.produce(factory, prod, units[best]);
+    if (made <= 0)
+        return;
+    world.market.placeSellOrder(prod.id, made, prod.price, factory.id);
+    simLog() << "AI Factory " << factory.id << " (greedy) produced and listed " << made
+        << " units of " << prod.name << ".\n";
+
+    std::vector<BasketLeg> legs;
+    for (const auto& req : prod.recipe)
+        legs.push_back({ req.first, made * req.second, scalePrice(commodityPrice(world, req.first), 105, 100), 0 });
+    if (!legs.empty())
+        world.market.placeBasketOrder(legs, BasketFill::Proportional, factory.id);
+}
+
+void MarketMaker::act(SimulationWorld& world, Factory& factory, State& state) {
+    Market& market = world.market;
+    // Filled quotes are already gone from the book; removeOrder just reports that.
+    if (state.bidId)
+        market.removeOrder(state.bidId, factory.id);
+    if (state.askId)
+        market.removeOrder(state.askId, factory.id);
+    state.bidId = state.askId = 0;
+    if (world.productCatalog.empty())
+        return;
+
+    // Each maker sticks to one product, spread over the catalog by factory id.
+    size_t index = static_cast<size_t>(factory.id < 0 ? -factory.id : factory.id) % world.productCatalog.size();
+    const Commodity& prod = world.productCatalog[index];
+    Price bid = std::max<Price>(scalePrice(prod.price, 98, 100), 1);
+    Price ask = std::max<Price>(scalePrice(prod.price, 102, 100), bid + 1);
+    state.bidId = market.placeBuyOrder(prod.id, QUOTE_SIZE, bid, factory.id);
+    state.askId = market.placeSellOrder(prod.id, QUOTE_SIZE, ask, factory.id);
+}
+
+void RandomTrader::act(SimulationWorld& world, Factory& factory, State& state) {
+    Market& market = world.market;
+    if (state.orderId)
+        market.removeOrder(state.orderId, factory.id);
+    state.orderId = 0;
+    size_t resources = world.resourceCatalog.size();
+    size_t count = resources + world.productCatalog.size();
+    if (count == 0)
+        return;
+
+    std::uniform_int_distribution<size_t> pick(0, count - 1);
+    std::uniform_int_distribution<int> side(0, 1);
+    std::uniform_int_distribution<int> amount(1, MAX_RANDOM_AMOUNT);
+    std::uniform_int_distribution<int> spreadPermille(950, 1050);
+    size_t index = pick(world.rng);
+    const Commodity& item = index < resources ? world.resourceCatalog[index] : world.productCatalog[index - resources];
+    bool buy = side(world.rng) != 0;
+    int quantity = amount(world.rng);
+    Price price = std::max<Price>(scalePrice(item.price, spreadPermille(world.rng), 1000), 1);
+    state.orderId = buy
+        ? market.placeBuyOrder(item.id, quantity, price, factory.id)
+        : market.placeSellOrder(item.id, quantity, price, factory.id);
+}
+
+bool parseAgentMix(const char* text, AgentMix& mix) {
+    int weights[4] = { 0, 0, 0, 0 };
+    const char* cursor = text;
+    for (int i = 0; i < 4 && *cursor; i++) {
+        char* end = nullptr;
+        long value = std::strtol(cursor, &end, 10);
+        if (end == cursor || value < 0 || value > 1000000)
+            return false;
+        weights[i] = static_cast<int>(value);
+        cursor = end;
+        if (*cursor == ',')
+            cursor++;
+        else if (*cursor)
+            return false;
+    }
+    if (*cursor || weights[0] + weights[1] + weights[2] + weights[3] <= 0)
+        return false;
+    mix.lpPlanner = weights[0];
+    mix.greedyProducer = weights[1];
+    mix.marketMaker = weights[2];
+    mix.randomTrader = weights[3];
+    return true;
+}
+
+AgentPopulation::AgentPopulation(const AgentMix& mix) : mix(mix) {}
+
+void AgentPopulation::assign(size_t factoryCount) {
+    const int weights[4] = { mix.lpPlanner, mix.greedyProducer, mix.marketMaker, mix.randomTrader };
+    int total = weights[0] + weights[1] + weights[2] + weights[3];
+    for (size_t i = agents.size(); i < factoryCount; i++) {
+        int index = static_cast<int>(i);
+        int position = total > 0 ? index % total : 0;
+        int kind = 0;
+        while (kind < 3 && position >= weights[kind]) {
+            position -= weights[kind];
+            kind++;
+        }
+        switch (static_cast<AgentKind>(kind)) {
+        case AgentKind::LpPlanner: add<LpPlanner>(AgentKind::LpPlanner, index); break;
+        case AgentKind::GreedyProducer: add<GreedyProducer>(AgentKind::GreedyProducer, index); break;
+        case AgentKind::MarketMaker: add<MarketMaker>(AgentKind::MarketMaker, index); break;
+        case AgentKind::RandomTrader: add<RandomTrader>(AgentKind::RandomTrader, index); break;
+        }
+    }
+}
+
+void AgentPopulation::act(SimulationWorld& world, int factoryIndex) {
+    const Agent& agent = agents[factoryIndex];
+    switch (agent.kind) {
+    case AgentKind::LpPlanner: std::get<AgentBatch<LpPlanner>>(batches).act(world, agent.position); break;
+    case AgentKind::GreedyProducer: std::get<AgentBatch<GreedyProducer>>(batches).act(world, agent.position); break;
+    case AgentKind::MarketMaker: std::get<AgentBatch<MarketMaker>>(batches).act(world, agent.position); break;
+    case AgentKind::RandomTrader: std::get<AgentBatch<RandomTrader>>(batches).act(world, agent.position); break;
+    }
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "AIController.h"
+#include "Initialization.h"
+
+// AI factory behaviours as compile-time policies. A policy is a class with a per-agent
+// State type and
+//     void act(SimulationWorld& world, Factory& factory, State& state);
+// Agents of one policy live together in an AgentBatch, and the population keeps one batch
+// per policy in a tuple, so stepping a batch is a plain loop over a concrete type with
+// no virtual calls; the compiler can inline act() into it.
+
+// The original LP planner (AIController).
+class LpPlanner {
+public:
+    struct State {};
+
+    void act(SimulationWorld& world, Factory& factory, State&) { controller.updateFactory(world, factory); }
+
+    AIController controller;
+};
+
+// Makes as much as it can of the single product with the highest margin at current
+// prices, lists it, and buys back the ingredients it used as one proportional basket.
+class GreedyProducer {
+public:
+    struct State {};
+
+    void act(SimulationWorld& world, Factory& factory, State& state);
+
+private:
+    std::vector<int> units;   // Scratch for ProductionEngine::maxProducible.
+};
+
+// Keeps a bid and an ask around the reference price of one product, replacing both quotes
+// on every turn.
+class MarketMaker {
+public:
+    struct State {
+        int bidId = 0;
+        int askId = 0;
+    };
+
+    void act(SimulationWorld& world, Factory& factory, State& state);
+};
+
+// Places one random order a turn, within 5% of a random commodity's price, and cancels its
+// previous order if it is still resting.
+class RandomTrader {
+public:
+    struct State {
+        int orderId = 0;
+    };
+
+    void act(SimulationWorld& world, Factory& factory, State& state);
+};
+
+// Every agent of one policy, with its state. Members are indices into world.aiFactories.
+template <typename Policy>
+class AgentBatch {
+public:
+    // Returns the agent's position in the batch.
+    size_t add(int factoryIndex) {
+        members.push_back(factoryIndex);
+        states.emplace_back();
+        return members.size() - 1;
+    }
+
+    size_t size() const { return members.size(); }
+
+    // One turn for the agent at 'position'.
+    void act(SimulationWorld& world, size_t position) {
+        policy.act(world, world.aiFactories[members[position]], states[position]);
+    }
+
+    // One turn for every agent in the batch.
+    void run(SimulationWorld& world) {
+        for (size_t i = 0; i < members.size(); i++)
+            policy.act(world, world.aiFactories[members[i]], states[i]);
+    }
+
+    Policy policy;
+
+private:
+    std::vector<int> members;
+    std::vector<typename Policy::State> states;
+};
+
+// Order matches the batches in AgentPopulation.
+enum class AgentKind { LpPlanner, GreedyProducer, MarketMaker, RandomTrader };
+
+// Relative share of each behaviour among the AI factories. Factories are assigned in
+// repeating groups: with 6,2,1,1, factories 0-5 plan with the LP, 6-7 are greedy, 8 makes
+// markets, 9 trades randomly, and 10-19 repeat the pattern.
+struct AgentMix {
+    int lpPlanner = 1;
+    int greedyProducer = 0;
+    int marketMaker = 0;
+    int randomTrader = 0;
+};
+
+// Parses "LP,GREEDY,MAKER,RANDOM" weights (missing trailing weights are 0). Returns false
+// unless every weight is a non-negative integer and at least one is positive.
+bool parseAgentMix(const char* text, AgentMix& mix);
+
+// The AI factories of a world, grouped into one batch per behaviour.
+class AgentPopulation {
+public:
+    explicit AgentPopulation(const AgentMix& mix = AgentMix());
+
+    // Assigns a behaviour to every factory index below 'factoryCount' that has none yet.
+    void assign(size_t factoryCount);
+
+    AgentKind kind(int factoryIndex) const { return agents[factoryIndex].kind; }
+    size_t size() const { return agents.size(); }
+
+    // One turn for a single factory (the event-driven simulation wakes them one at a time).
+    void act(SimulationWorld& world, int factoryIndex);
+
+    // One turn for every factory, batch by batch.
+    void runAll(SimulationWorld& world) {
+        std::apply([&](auto&... batch) { (batch.run(world), ...); }, batches);
+    }
+
+    // The LP planner's controller, for its settings.
+    AIController& lpController() { return std::get<AgentBatch<LpPlanner>>(batches).policy.controller; }
+
+private:
+    struct Agent {
+        AgentKind kind;
+        size_t position;   // In its batch.
+    };
+
+    template <typename Policy>
+    void add(AgentKind kind, int factoryIndex) {
+        agents.push_back({ kind, std::get<AgentBatch<Policy>>(batches).add(factoryIndex) });
+    }
+
+    AgentMix mix;
+    std::vector<Agent> agents;   // By factory index.
+    std::tuple<AgentBatch<LpPlanner>, AgentBatch<GreedyProducer>, AgentBatch<MarketMaker>,
+               AgentBatch<RandomTrader>> batches;
+};
@@ -0,0 +1,968 @@
+// Microbenchmarks for the simulation core engines.
+//
+// Usage: market_bench [--iterations N] [--filter TEXT] [--json FILE]
+//
+// Every benchmark times individual operations, so results are reported as mean ns/op
+// together with latency percentiles. --json writes the same numbers in a machine-readable
+// form ("-" for stdout, in which case the table goes to stderr) so runs can be compared
+// for regressions.
+#include "Initialization.h"
+#include "AIController.h"
+#include "AgentStrategies.h"
+#include "SimplexAlgorithm.h"
+#include "Simulation.h"
+#include "Log.h"
+#include "MarketDataFeed.h"
+#include "Scenario.h"
+#include "ResourceMarket.h"
+#include "MatchingEngine.h"
+#include "FixedWorld.h"
+#if defined(__linux__)
+#include "Gateway.h"
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct BenchResult {
+    std::string name;
+    size_t iterations;
+    double meanNs;
+    double p50Ns;
+    double p90Ns;
+    double p99Ns;
+    double maxNs;
+};
+
+struct BenchOptions {
+    size_t iterations = 2000;
+    std::string filter;
+    std::string jsonPath;
+};
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsedNs(Clock::time_point start, Clock::time_point end) {
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+// Sorts the samples and reduces them to mean and percentiles.
+static BenchResult summarize(const std::string& name, std::vector<double>& samples) {
+    BenchResult result = { name, samples.size(), 0.0, 0.0, 0.0, 0.0, 0.0 };
+    if (samples.empty())
+        return result;
+    std::sort(samples.begin(), samples.end());
+    double total = 0.0;
+    for (double s : samples)
+        total += s;
+    auto percentile = [&](double p) {
+        size_t idx = static_cast<size_t>(p * (samples.size() - 1) + 0.5);
+        return samples[idx];
+    };
+    result.meanNs = total / samples.size();
+    result.p50Ns = percentile(0.50);
+    result.p90Ns = percentile(0.90);
+    result.p99Ns = percentile(0.99);
+    result.maxNs = samples.back();
+    return result;
+}
+
+// --- Market ---
+
+const int BENCH_PRODUCT = 1;
+const int BOOK_OWNER = 2;   // Owner of the resting depth.
+const int TAKER_OWNER = 3;  // Owner of the orders placed by the benchmark.
+const int LARGE_AMOUNT = 1000000000;
+
+// Fills both sides of the book for BENCH_PRODUCT with 'depth' non-crossing orders each.
+// Bids rest in [90, 99], asks in [101, 110]. Returns the ids of the resting bids.
+// Orders are appended directly: nothing can cross, and going through placeBuyOrder would
+// re-run the matcher for every order and make deep books quadratic to set up.
+static std::vector<int> fillBook(Market& market, int depth, std::mt19937& gen) {
+    std::uniform_int_distribution<Price> bidDist(unitsToPrice(90), unitsToPrice(99));
+    std::uniform_int_distribution<Price> askDist(unitsToPrice(101), unitsToPrice(110));
+    std::vector<int> bidIds;
+    for (int i = 0; i < depth; i++) {
+        Order bid = { market.nextOrderId++, BENCH_PRODUCT, OrderType::BUY, bidDist(gen), LARGE_AMOUNT, BOOK_OWNER };
+        Order ask = { market.nextOrderId++, BENCH_PRODUCT, OrderType::SELL, askDist(gen), LARGE_AMOUNT, BOOK_OWNER };
+        market.books[BENCH_PRODUCT].write().push_back(bid);
+        market.books[BENCH_PRODUCT].write().push_back(ask);
+        bidIds.push_back(bid.id);
+    }
+    market.recountRestingAmounts();
+    return bidIds;
+}
+
+// Resting (non-crossing) BUY order entry; the order is cancelled again outside the timed region.
+static BenchResult benchMarketPlace(int depth, size_t iterations) {
+    std::mt19937 gen(42);
+    Market market;
+    fillBook(market, depth, gen);
+    std::uniform_int_distribution<Price> priceDist(unitsToPrice(90), unitsToPrice(99));
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        Price price = priceDist(gen);
+        auto start = Clock::now();
+        int id = market.placeBuyOrder(BENCH_PRODUCT, 1, price, TAKER_OWNER);
+        auto end = Clock::now();
+        samples.push_back(elapsedNs(start, end));
+        market.removeOrder(id, TAKER_OWNER);
+    }
+    return summarize("Market/place/depth=" + std::to_string(depth), samples);
+}
+
+// Marketable SELL order that trades one unit against the best bid. The resting bids are
+// large, so the book depth stays constant across iterations.
+static BenchResult benchMarketMatch(int depth, size_t iterations) {
+    std::mt19937 gen(43);
+    Market market;
+    fillBook(market, depth, gen);
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        auto start = Clock::now();
+        market.placeSellOrder(BENCH_PRODUCT, 1, unitsToPrice(1), TAKER_OWNER);
+        auto end = Clock::now();
+        samples.push_back(elapsedNs(start, end));
+        market.trades.clear();
+    }
+    return summarize("Market/match/depth=" + std::to_string(depth), samples);
+}
+
+// Cancel of a random resting bid; a replacement bid is entered outside the timed region.
+static BenchResult benchMarketCancel(int depth, size_t iterations) {
+    std::mt19937 gen(44);
+    Market market;
+    std::vector<int> bidIds = fillBook(market, depth, gen);
+    std::uniform_int_distribution<Price> priceDist(unitsToPrice(90), unitsToPrice(99));
+    std::uniform_int_distribution<size_t> pick(0, bidIds.size() - 1);
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        size_t idx = pick(gen);
+        auto start = Clock::now();
+        market.removeOrder(bidIds[idx], BOOK_OWNER);
+        auto end = Clock::now();
+        samples.push_back(elapsedNs(start, end));
+        bidIds[idx] = market.placeBuyOrder(BENCH_PRODUCT, LARGE_AMOUNT, priceDist(gen), BOOK_OWNER);
+    }
+    return summarize("Market/cancel/depth=" + std::to_string(depth), samples);
+}
+
+// Buys one unit of each of 'legs' products, as a single proportional basket or as one BUY
+// order per product. Every product has 'depth' large resting asks, so the book keeps its
+// shape across iterations.
+static BenchResult benchMarketBasket(int legs, bool basket, int depth, size_t iterations) {
+    std::mt19937 gen(45);
+    Market market;
+    std::uniform_int_distribution<Price> askDist(unitsToPrice(101), unitsToPrice(110));
+    for (int product = 1; product <= legs; product++) {
+        for (int i = 0; i < depth; i++)
+            market.books[product].write().push_back({ market.nextOrderId++, product, OrderType::SELL, askDist(gen), LARGE_AMOUNT, BOOK_OWNER });
+    }
+    market.recountRestingAmounts();
+    std::vector<BasketLeg> basketLegs;
+    for (int product = 1; product <= legs; product++)
+        basketLegs.push_back({ product, 1, unitsToPrice(110), 0 });
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        auto start = Clock::now();
+        if (basket) {
+            market.placeBasketOrder(basketLegs, BasketFill::Proportional, TAKER_OWNER);
+        }
+        else {
+            for (const auto& leg : basketLegs)
+                market.placeBuyOrder(leg.productId, leg.amount, leg.maxPrice, TAKER_OWNER);
+        }
+        auto end = Clock::now();
+        samples.push_back(elapsedNs(start, end));
+        market.trades.clear();
+    }
+    return summarize(std::string(basket ? "Market/basket" : "Market/orders") + "/legs=" + std::to_string(legs), samples);
+}
+
+// --- Matching engine ---
+
+// 'producers' threads each submit 'iterations' one-unit orders that cross each other, so
+// the book stays small; this thread drains the acks. Each sample is one command's
+// enqueue-to-ack latency; producers submit as fast as they can, so it includes the time
+// spent queued behind other commands. Warns if the acks are not numbered 0, 1, 2, ... or if a
+// producer's commands were applied out of its submission order.
+static BenchResult benchMatchingEngine(int producers, size_t iterations) {
+    Market market;
+    MatchingEngine engine(market);
+    engine.start();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&engine, p, iterations] {
+            for (size_t i = 0; i < iterations; i++) {
+                OrderCommand command{};
+                command.type = (i + p) % 2 == 0 ? CommandType::BUY : CommandType::SELL;
+                command.productId = BENCH_PRODUCT;
+                command.amount = 1;
+                command.price = unitsToPrice(100);
+                command.ownerId = TAKER_OWNER + p;
+                command.clientTag = (static_cast<uint64_t>(p) << 32) | i;
+                while (!engine.submit(command))
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    size_t total = static_cast<size_t>(producers) * iterations;
+    std::vector<double> samples;
+    samples.reserve(total);
+    std::vector<int64_t> lastTag(producers, -1);
+    bool ordered = true;
+    CommandAck ack;
+    while (samples.size() < total) {
+        if (!engine.pollAck(ack)) {
+            std::this_thread::yield();
+            continue;
+        }
+        int64_t& last = lastTag[ack.clientTag >> 32];
+        int64_t tag = static_cast<int64_t>(ack.clientTag & 0xffffffffu);
+        ordered = ordered && ack.sequence == samples.size() && tag > last;
+        last = tag;
+        samples.push_back(static_cast<double>(ack.ackNs - ack.enqueueNs));
+    }
+    for (auto& thread : threads)
+        thread.join();
+    engine.stop();
+    if (!ordered)
+        std::cerr << "Matching: acks out of sequence or out of producer order\n";
+    if (!market.trades.empty())
+        std::cerr << "Matching: " << market.trades.size() << " trades left in the market\n";
+    return summarize("Matching/ack/producers=" + std::to_string(producers), samples);
+}
+
+// --- Simplex ---
+
+// Builds a feasible, bounded production-style LP: maximize c.x subject to A.x <= b, x >= 0,
+// with 'size' constraints and 'size' variables, in the tableau layout Simplex expects.
+static std::vector<std::vector<double>> generateLp(int size, std::mt19937& gen) {
+    std::uniform_real_distribution<double> profitDist(1.0, 10.0);
+    std::uniform_real_distribution<double> coeffDist(0.0, 10.0);
+    std::uniform_real_distribution<double> rhsDist(50.0, 500.0);
+    std::vector<std::vector<double>> tableau(size + 1, std::vector<double>(size + 1, 0.0));
+    for (int j = 0; j < size; j++)
+        tableau[0][j] = -profitDist(gen);
+    for (int i = 1; i <= size; i++) {
+        for (int j = 0; j < size; j++)
+            tableau[i][j] = coeffDist(gen);
+        tableau[i][size] = rhsDist(gen);
+    }
+    return tableau;
+}
+
+// With a budget, each solve stops at its deadline (SolveStatus::TimedOut), as a planning
+// AI factory's would.
+static BenchResult benchSimplex(int size, std::chrono::microseconds budget, size_t iterations) {
+    std::mt19937 gen(45);
+    const int NUM_PROBLEMS = 16;
+    std::vector<std::vector<std::vector<double>>> problems;
+    for (int i = 0; i < NUM_PROBLEMS; i++)
+        problems.push_back(generateLp(size, gen));
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        Simplex simplex(problems[i % NUM_PROBLEMS]);
+        auto start = Clock::now();
+        if (budget.count() > 0)
+            simplex.solve(start + budget);
+        else
+            simplex.solve();
+        auto end = Clock::now();
+        samples.push_back(elapsedNs(start, end));
+    }
+    if (budget.count() > 0)
+        return summarize("Simplex/budget=" + std::to_string(budget.count()) + "us/size=" + std::to_string(size), samples);
+    return summarize("Simplex/solve/size=" + std::to_string(size), samples);
+}
+
+// --- Event queue ---
+
+// One popNext plus one schedule per iteration, with 'depth' events kept pending.
+static BenchResult benchEventQueue(int depth, size_t iterations) {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<SimTime> offset(1, TICKS_PER_DAY);
+    EventScheduler scheduler;
+    SimEvent event{};
+    event.type = EventType::AgentWakeup;
+    for (int i = 0; i < depth; i++) {
+        event.time = offset(gen);
+        scheduler.schedule(event);
+    }
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        SimTime next = offset(gen);
+        auto start = Clock::now();
+        scheduler.popNext(std::numeric_limits<SimTime>::max(), event);
+        event.time += next;
+        scheduler.schedule(event);
+        auto end = Clock::now();
+        samples.push_back(elapsedNs(start, end));
+    }
+    return summarize("Events/queue/depth=" + std::to_string(depth), samples);
+}
+
+// One simulated day per iteration with 'arrivals' outside orders per resource per day.
+// A fresh world is started every 30 days so the books stay at a realistic size.
+static BenchResult benchEventDay(int arrivals, size_t iterations) {
+    const int RESET_INTERVAL = 30;
+    IntradayConfig config;
+    config.orderArrivalsPerDay = arrivals;
+    AgentPopulation agents;
+    SimulationWorld world;
+    std::unique_ptr<EventSimulation> simulation;
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        int day = static_cast<int>(i % RESET_INTERVAL) + 1;
+        if (day == 1) {
+            simulation.reset();
+            world = initializeSimulation(static_cast<unsigned int>(i));
+            simulation.reset(new EventSimulation(world, agents, config));
+        }
+        auto start = Clock::now();
+        simulation->runDay(day);
+        auto end = Clock::now();
+        samples.push_back(elapsedNs(start, end));
+    }
+    return summarize("Events/day/arrivals=" + std::to_string(arrivals), samples);
+}
+
+// --- Market data ---
+
+// Cost the matching path pays per book change with a shared-memory feed attached:
+// one seqlock-guarded publishBook of a book 'depth' orders deep on each side.
+static BenchResult benchFeedPublish(int depth, size_t iterations) {
+    std::string name = "Feed/publish/depth=" + std::to_string(depth);
+    MarketDataFeed feed;
+    if (!feed.create("/market_bench_feed")) {
+        std::vector<double> none;
+        return summarize(name + " (unavailable)", none);
+    }
+    std::vector<Order> orders;
+    for (int i = 0; i < depth; i++) {
+        orders.push_back({ 2 * i + 1, 1, OrderType::BUY, unitsToPrice(100) - i * PRICE_TICKS_PER_UNIT / 2, 10, 0 });
+        orders.push_back({ 2 * i + 2, 1, OrderType::SELL, unitsToPrice(101) + i * PRICE_TICKS_PER_UNIT / 2, 10, 0 });
+    }
+    std::vector<Order*> bids;
+    std::vector<Order*> asks;
+    for (auto& order : orders)
+        (order.type == OrderType::BUY ? bids : asks).push_back(&order);
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        auto start = Clock::now();
+        feed.publishBook(1, bids, asks);
+        auto end = Clock::now();
+        samples.push_back(elapsedNs(start, end));
+    }
+    return summarize(name, samples);
+}
+
+#if defined(__linux__)
+// --- Order-entry gateway ---
+
+// Round trips over a Unix domain socket to a gateway polling on its own thread. Each
+// iteration sends 'batch' amendments of one resting order and waits for all their reports;
+// the sample is the time per message, so batch=1 is the full round-trip latency.
+static BenchResult benchGateway(size_t batch, size_t iterations) {
+    std::string path = "/tmp/market_bench_gateway." + std::to_string(getpid()) + ".sock";
+    Market market;
+    Gateway gateway(market);
+    if (!gateway.open(path)) {
+        std::vector<double> none;
+        return summarize("Gateway/unavailable", none);
+    }
+    std::atomic<bool> stop(false);
+    std::thread server([&] {
+        setLogEnabled(false);
+        while (!stop.load(std::memory_order_relaxed))
+            gateway.poll(10);
+    });
+
+    GatewayClient client;
+    client.connect(path);
+    GatewayRequest request{};
+    request.type = static_cast<uint8_t>(GatewayRequestType::NewOrder);
+    request.side = static_cast<uint8_t>(GatewaySide::Buy);
+    request.productId = 1;
+    request.amount = 10;
+    request.price = unitsToPrice(1);
+    client.send(&request, 1);
+    GatewayReport reports[256];
+    client.receive(reports, 1);
+
+    std::vector<GatewayRequest> amends(batch, request);
+    for (size_t i = 0; i < batch; i++) {
+        amends[i].type = static_cast<uint8_t>(GatewayRequestType::Amend);
+        amends[i].orderId = reports[0].orderId;
+        amends[i].clientTag = i;
+    }
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        auto start = Clock::now();
+        client.send(amends.data(), batch);
+        for (size_t received = 0; received < batch;)
+            received += client.receive(reports, 256);
+        auto end = Clock::now();
+        samples.push_back(elapsedNs(start, end) / batch);
+    }
+
+    client.disconnect();
+    stop.store(true);
+    server.join();
+    return summarize("Gateway/amend/batch=" + std::to_string(batch), samples);
+}
+#endif
+
+// --- AI and initialization ---
+
+// One AIController::updateFactory call per iteration, cycling through the AI factories.
+// The world is reset periodically so the order book does not grow without bound.
+static BenchResult benchUpdateFactory(size_t iterations) {
+    SimulationWorld base = initializeSimulation();
+    SimulationWorld world = base;
+    AIController aiController;
+    const size_t RESET_INTERVAL = 500;
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        if (i > 0 && i % RESET_INTERVAL == 0)
+            world = base;
+        Factory& factory = world.aiFactories[i % world.aiFactories.size()];
+        auto start = Clock::now();
+        aiController.updateFactory(world, factory);
+        auto end = Clock::now();
+        samples.push_back(elapsedNs(start, end));
+    }
+    return summarize("AIController/updateFactory", samples);
+}
+
+// One AgentPopulation::runAll over 'agents' factories, an even mix of the four behaviours
+// (the generated factories, copied with fresh ids). Each sample is a whole step, on a copy
+// of the starting world made outside the timed region.
+static BenchResult benchAgentStep(int agents, size_t iterations) {
+    SimulationWorld base = initializeSimulation(46);
+    std::vector<Factory> generated = base.aiFactories;
+    base.aiFactories.clear();
+    for (int i = 0; i < agents; i++) {
+        base.aiFactories.push_back(generated[i % generated.size()]);
+        base.aiFactories.back().id = i + 2;
+    }
+    AgentMix mix;
+    mix.lpPlanner = mix.greedyProducer = mix.marketMaker = mix.randomTrader = 1;
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        SimulationWorld world = base;
+        AgentPopulation population(mix);
+        population.assign(world.aiFactories.size());
+        auto start = Clock::now();
+        population.runAll(world);
+        auto end = Clock::now();
+        samples.push_back(elapsedNs(start, end));
+    }
+    return summarize("Agents/step/agents=" + std::to_string(agents), samples);
+}
+
+// An agent that only waits for the next day, to time the scheduler's resume path.
+static AgentTask dayCounter(AgentScheduler& scheduler, long& days) {
+    while (true) {
+        co_await scheduler.nextDay();
+        days++;
+    }
+}
+
+static BenchResult benchCoroutineDay(int agents, size_t iterations) {
+    SimulationWorld world = initializeSimulation(47);
+    AgentScheduler scheduler(world);
+    long days = 0;
+    for (int i = 0; i < agents; i++)
+        scheduler.spawn(dayCounter(scheduler, days));
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        auto start = Clock::now();
+        scheduler.closeDay();
+        scheduler.runReady();
+        auto end = Clock::now();
+        samples.push_back(elapsedNs(start, end));
+    }
+    if (days != static_cast<long>(agents) * static_cast<long>(iterations))
+        std::cerr << "Coroutines/day: " << days << " resumes, expected " << agents * iterations << "\n";
+    return summarize("Coroutines/day/agents=" + std::to_string(agents), samples);
+}
+
+static BenchResult benchInitialize(size_t iterations) {
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        auto start = Clock::now();
+        SimulationWorld world = initializeSimulation();
+        auto end = Clock::now();
+        samples.push_back(elapsedNs(start, end));
+    }
+    return summarize("initializeSimulation", samples);
+}
+
+// A scenario with 'commodities' resources, a tenth as many products (three ingredients
+// and one equipment requirement each) and 'factories' AI factories with two stock lines.
+static std::string generateScenario(int commodities, int factories) {
+    std::string text;
+    for (int e = 1; e <= 10; e++)
+        text += "equipment," + std::to_string(e) + ",25.00," + std::to_string(e) + ",12.50\n";
+    for (int r = 1; r <= commodities; r++)
+        text += "resource," + std::to_string(r) + ",Resource " + std::to_string(r) + "," + std::to_string(r % 100 + 1) + ".25\n";
+    int products = std::max(1, commodities / 10);
+    for (int p = 0; p < products; p++) {
+        std::string id = std::to_string(commodities + 1 + p);
+        text += "product," + id + ",Product " + id + ",310.50\n";
+        for (int k = 0; k < 3; k++)
+            text += "recipe," + id + "," + std::to_string((p * 3 + k) % commodities + 1) + ",2\n";
+        text += "requires," + id + "," + std::to_string(p % 10 + 1) + ",1\n";
+    }
+    for (int f = 0; f < factories; f++) {
+        std::string id = std::to_string(2 + f);
+        text += "factory," + id + ",1000\n";
+        text += "stock," + id + "," + std::to_string(f % commodities + 1) + ",10\n";
+        text += "stock," + id + "," + std::to_string((f + 1) % commodities + 1) + ",5\n";
+    }
+    return text;
+}
+
+static BenchResult benchScenarioParse(int size, size_t iterations) {
+    std::string text = generateScenario(size, size);
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        std::string error;
+        auto start = Clock::now();
+        {
+            SimulationWorld world;
+            parseScenario(text.data(), text.size(), 1, world, error);
+        }
+        auto end = Clock::now();
+        samples.push_back(elapsedNs(start, end));
+    }
+    return summarize("Scenario/parse/size=" + std::to_string(size), samples);
+}
+
+// Producible units of every product for one factory that holds every resource.
+static BenchResult benchMaxProducible(int size, size_t iterations) {
+    std::string text = generateScenario(size, 1);
+    SimulationWorld world;
+    std::string error;
+    parseScenario(text.data(), text.size(), 1, world, error);
+    Factory& factory = world.aiFactories.front();
+    factory.inventory.write().clear();
+    for (const auto& res : world.resourceCatalog)
+        factory.inventory.write().push_back({ res, 100 });
+    for (const auto& equip : world.equipmentCatalog)
+        factory.addEquipment(equip, 2);
+    std::vector<int> units;
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        auto start = Clock::now();
+        world.production.maxProducible(factory, units);
+        auto end = Clock::now();
+        samples.push_back(elapsedNs(start, end));
+    }
+    return summarize("Production/max/size=" + std::to_string(size), samples);
+}
+
+// Daily price update over 'size' resources (and a tenth as many products). Each update
+// lists fresh supply, so the book grows by 'size' orders per iteration.
+static BenchResult benchPriceUpdate(int size, size_t iterations) {
+    std::string text = generateScenario(size, 10);
+    SimulationWorld world;
+    std::string error;
+    parseScenario(text.data(), text.size(), 1, world, error);
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        auto start = Clock::now();
+        updateMarketPrices(world);
+        auto end = Clock::now();
+        samples.push_back(elapsedNs(start, end));
+    }
+    return summarize("Prices/update/size=" + std::to_string(size), samples);
+}
+
+// --- World forks ---
+
+// A scenario world with 'factories' AI factories, each stocked with every resource, and a
+// book of a few thousand resting orders.
+static SimulationWorld forkBenchWorld(int factories) {
+    std::string text = generateScenario(100, factories);
+    SimulationWorld world;
+    std::string error;
+    parseScenario(text.data(), text.size(), 1, world, error);
+    for (Factory& factory : world.aiFactories) {
+        std::vector<std::pair<Commodity, int>>& inventory = factory.inventory.write();
+        inventory.clear();
+        for (const auto& res : world.resourceCatalog)
+            inventory.push_back({ res, 100 });
+    }
+    for (int day = 0; day < 30; day++)
+        updateMarketPrices(world);
+    return world;
+}
+
+// Forking and discarding a world. With 'unshare', the fork also takes its own copy of the
+// book and of every factory's equipment and inventory, which is what copying a world
+// cost before they were shared.
+static BenchResult benchWorldFork(int factories, bool unshare, size_t iterations) {
+    SimulationWorld world = forkBenchWorld(factories);
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        auto start = Clock::now();
+        {
+            SimulationWorld fork = forkWorld(world);
+            if (unshare) {
+                for (auto& entry : fork.market.books)
+                    entry.second.write();
+                for (Factory& factory : fork.aiFactories) {
+                    factory.equipment.write();
+                    factory.inventory.write();
+                }
+            }
+        }
+        auto end = Clock::now();
+        samples.push_back(elapsedNs(start, end));
+    }
+    std::string name = unshare ? "World/copy/factories=" : "World/fork/factories=";
+    return summarize(name + std::to_string(factories), samples);
+}
+
+// A what-if: fork the generated world, place one large order in the fork, run it three
+// days ahead and throw it away. The original world must come out unchanged.
+static BenchResult benchWorldWhatIf(size_t iterations) {
+    SimulationWorld world = initializeSimulation(50);
+    updateMarketPrices(world);
+    size_t restingBefore = world.market.orderCount();
+    const Commodity& target = world.resourceCatalog.front();
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        auto start = Clock::now();
+        {
+            SimulationWorld fork = forkWorld(world);
+            AgentPopulation agents;
+            EventSimulation simulation(fork, agents);
+            fork.market.placeBuyOrder(target.id, 500, target.price * 2, fork.playerFactory.id);
+            for (int day = 1; day <= 3; day++)
+                simulation.runDay(day);
+        }
+        auto end = Clock::now();
+        samples.push_back(elapsedNs(start, end));
+    }
+    bool shared = std::any_of(world.market.books.begin(), world.market.books.end(), [](const auto& entry) {
+        return entry.second.shared();
+        });
+    if (world.market.orderCount() != restingBefore || shared)
+        std::cerr << "World/whatif: the forks changed the original world\n";
+    return summarize("World/whatif/days=3", samples);
+}
+
+// --- Fixed-size world ---
+// The same kernels over the dynamic engines' vectors and over DefaultFixedWorld's arrays,
+// on the AI factories of a generated world, each stocked with every resource and equipment
+// type. Each iteration covers every factory. A warning is printed if the two disagree.
+
+static SimulationWorld fixedBenchWorld(DefaultFixedWorld& fixed) {
+    SimulationWorld world = initializeSimulation(48);
+    for (Factory& factory : world.aiFactories) {
+        factory.inventory.write().clear();
+        for (const auto& res : world.resourceCatalog)
+            factory.inventory.write().push_back({ res, 100 });
+        for (const auto& equip : world.equipmentCatalog)
+            factory.addEquipment(equip, 2);
+    }
+    if (!fixed.load(world))
+        std::cerr << "World: the generated world does not fit DefaultFixedWorld\n";
+    return world;
+}
+
+static BenchResult benchWorldProduction(bool useFixed, size_t iterations) {
+    DefaultFixedWorld fixed;
+    SimulationWorld world = fixedBenchWorld(fixed);
+    std::vector<int> units;
+    std::array<int, NUM_PRODUCTS> fixedUnits;
+    for (size_t f = 0; f < world.aiFactories.size(); f++) {
+        world.production.maxProducible(world.aiFactories[f], units);
+        fixed.maxProducible(fixed.factories[f], fixedUnits);
+        if (!std::equal(units.begin(), units.end(), fixedUnits.begin()))
+            std::cerr << "World/production: factory " << world.aiFactories[f].id << " differs\n";
+    }
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        auto start = Clock::now();
+        for (size_t f = 0; f < world.aiFactories.size(); f++) {
+            if (useFixed)
+                fixed.maxProducible(fixed.factories[f], fixedUnits);
+            else
+                world.production.maxProducible(world.aiFactories[f], units);
+        }
+        auto end = Clock::now();
+        samples.push_back(elapsedNs(start, end));
+    }
+    return summarize(useFixed ? "World/fixed/production" : "World/dynamic/production", samples);
+}
+
+// Dynamic: Simplex over a vector copy of each factory's tableau (its construction is not
+// timed). Fixed: building the array tableau and solving it.
+static BenchResult benchWorldLp(bool useFixed, size_t iterations) {
+    DefaultFixedWorld fixed;
+    SimulationWorld world = fixedBenchWorld(fixed);
+    std::vector<std::vector<std::vector<double>>> tableaus;
+    std::array<double, NUM_PRODUCTS> quantities;
+    for (const auto& factory : fixed.factories) {
+        DefaultFixedWorld::Tableau tableau;
+        fixed.buildTableau(factory, tableau);
+        tableaus.emplace_back();
+        for (const auto& row : tableau)
+            tableaus.back().emplace_back(row.begin(), row.end());
+        Simplex simplex(tableaus.back());
+        simplex.solve();
+        std::vector<double> solution = simplex.getSolution();
+        fixed.plan(factory, quantities);
+        double dynamicValue = 0.0, fixedValue = 0.0;
+        for (size_t p = 0; p < quantities.size(); p++) {
+            dynamicValue -= tableaus.back()[0][p] * solution[p];
+            fixedValue -= tableaus.back()[0][p] * quantities[p];
+        }
+        if (std::fabs(dynamicValue - fixedValue) > 1e-6 * (1.0 + std::fabs(dynamicValue)))
+            std::cerr << "World/lp: factory " << factory.id << " differs\n";
+    }
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        auto start = Clock::now();
+        for (size_t f = 0; f < tableaus.size(); f++) {
+            if (useFixed) {
+                fixed.plan(fixed.factories[f], quantities);
+            }
+            else {
+                Simplex simplex(tableaus[f]);
+                simplex.solve();
+                simplex.getSolution();
+            }
+        }
+        auto end = Clock::now();
+        samples.push_back(elapsedNs(start, end));
+    }
+    return summarize(useFixed ? "World/fixed/lp" : "World/dynamic/lp", samples);
+}
+
+// PriceEngine::computeNextPrices over vectors with a runtime size, and over the fixed
+// world's arrays.
+static BenchResult benchWorldPrices(bool useFixed, size_t iterations) {
+    DefaultFixedWorld fixed;
+    SimulationWorld world = fixedBenchWorld(fixed);
+    DefaultFixedWorld::DayInputs inputs;
+    std::mt19937 gen(49);
+    std::uniform_int_distribution<int64_t> amount(0, 1000);
+    for (size_t i = 0; i < DefaultFixedWorld::Commodities; i++) {
+        inputs.demand[i] = amount(gen);
+        inputs.supply[i] = amount(gen) + 1;
+        inputs.tradedVolume[i] = amount(gen) / 10;
+        inputs.tradedNotional[i] = inputs.tradedVolume[i] * fixed.prices[i];
+    }
+    std::vector<Price> prices(fixed.prices.begin(), fixed.prices.end());
+    std::vector<Price> next(prices.size());
+    std::vector<int64_t> demand(inputs.demand.begin(), inputs.demand.end());
+    std::vector<int64_t> supply(inputs.supply.begin(), inputs.supply.end());
+    std::vector<int64_t> volume(inputs.tradedVolume.begin(), inputs.tradedVolume.end());
+    std::vector<int64_t> notional(inputs.tradedNotional.begin(), inputs.tradedNotional.end());
+    std::vector<int64_t> denominators(prices.size());
+    DefaultFixedWorld check = fixed;
+    check.updatePrices(inputs);
+    PriceEngine::computeNextPrices(world.resourceCatalog.size(), prices.size(), prices,
+                                   demand, supply, volume, notional, denominators, next);
+    if (!std::equal(next.begin(), next.end(), check.prices.begin()))
+        std::cerr << "World/prices: results differ\n";
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        auto start = Clock::now();
+        if (useFixed) {
+            fixed.updatePrices(inputs);
+        }
+        else {
+            PriceEngine::computeNextPrices(world.resourceCatalog.size(), prices.size(), prices,
+                                           demand, supply, volume, notional, denominators, next);
+            prices.swap(next);
+        }
+        auto end = Clock::now();
+        samples.push_back(elapsedNs(start, end));
+    }
+    return summarize(useFixed ? "World/fixed/prices" : "World/dynamic/prices", samples);
+}
+
+// --- Reporting ---
+
+static void printResult(std::ostream& out, const BenchResult& r) {
+    out << std::left << std::setw(32) << r.name << std::right << std::fixed << std::setprecision(0)
+        << std::setw(10) << r.iterations
+        << std::setw(14) << r.meanNs
+        << std::setw(12) << r.p50Ns
+        << std::setw(12) << r.p90Ns
+        << std::setw(12) << r.p99Ns
+        << std::setw(14) << r.maxNs << "\n";
+}
+
+static void writeJson(std::ostream& out, const std::vector<BenchResult>& results) {
+    out << "{\n  \"unit\": \"ns\",\n  \"benchmarks\": [\n";
+    out << std::fixed << std::setprecision(1);
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\""
+            << ", \"iterations\": " << r.iterations
+            << ", \"ns_per_op\": " << r.meanNs
+            << ", \"p50\": " << r.p50Ns
+            << ", \"p90\": " << r.p90Ns
+            << ", \"p99\": " << r.p99Ns
+            << ", \"max\": " << r.maxNs << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+static bool parseArgs(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc)
+            options.iterations = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--filter" && i + 1 < argc)
+            options.filter = argv[++i];
+        else if (arg == "--json" && i + 1 < argc)
+            options.jsonPath = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--iterations N] [--filter TEXT] [--json FILE]\n";
+            return false;
+        }
+    }
+    if (options.iterations == 0)
+        options.iterations = 1;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!parseArgs(argc, argv, options))
+        return 1;
+
+    // The engines narrate every order and decision; keep that out of the measurements.
+    setLogEnabled(false);
+
+    struct BenchCase {
+        std::string name;
+        std::function<BenchResult()> run;
+    };
+    const size_t iterations = options.iterations;
+    std::vector<BenchCase> cases;
+    for (int depth : { 10, 100, 1000, 10000 }) {
+        cases.push_back({ "Market/place/depth=" + std::to_string(depth), [=] { return benchMarketPlace(depth, iterations); } });
+        cases.push_back({ "Market/match/depth=" + std::to_string(depth), [=] { return benchMarketMatch(depth, iterations); } });
+        cases.push_back({ "Market/cancel/depth=" + std::to_string(depth), [=] { return benchMarketCancel(depth, iterations); } });
+    }
+    for (int legs : { 4, 16 }) {
+        cases.push_back({ "Market/basket/legs=" + std::to_string(legs), [=] { return benchMarketBasket(legs, true, 100, iterations); } });
+        cases.push_back({ "Market/orders/legs=" + std::to_string(legs), [=] { return benchMarketBasket(legs, false, 100, iterations); } });
+    }
+    for (int producers : { 1, 4 })
+        cases.push_back({ "Matching/ack/producers=" + std::to_string(producers), [=] { return benchMatchingEngine(producers, iterations * 10); } });
+    for (int size : { 5, 10, 25, 50, 100 })
+        cases.push_back({ "Simplex/solve/size=" + std::to_string(size), [=] { return benchSimplex(size, std::chrono::microseconds(0), iterations); } });
+    cases.push_back({ "Simplex/budget=20us/size=100", [=] { return benchSimplex(100, std::chrono::microseconds(20), iterations); } });
+    for (int depth : { 100, 10000, 1000000 })
+        cases.push_back({ "Events/queue/depth=" + std::to_string(depth), [=] { return benchEventQueue(depth, iterations); } });
+    for (int arrivals : { 0, 1000 })
+        cases.push_back({ "Events/day/arrivals=" + std::to_string(arrivals), [=] { return benchEventDay(arrivals, std::max<size_t>(1, iterations / 10)); } });
+    for (int depth : { 10, 1000 })
+        cases.push_back({ "Feed/publish/depth=" + std::to_string(depth), [=] { return benchFeedPublish(depth, iterations); } });
+#if defined(__linux__)
+    for (size_t batch : { 1, 64 })
+        cases.push_back({ "Gateway/amend/batch=" + std::to_string(batch), [=] { return benchGateway(batch, iterations); } });
+#endif
+    cases.push_back({ "AIController/updateFactory", [=] { return benchUpdateFactory(iterations); } });
+    for (int agents : { 1000, 10000 })
+        cases.push_back({ "Agents/step/agents=" + std::to_string(agents), [=] { return benchAgentStep(agents, std::max<size_t>(1, iterations / 100)); } });
+    // World generation is comparatively slow; a tenth of the iterations is plenty.
+    for (int agents : { 1000, 100000 })
+        cases.push_back({ "Coroutines/day/agents=" + std::to_string(agents), [=] { return benchCoroutineDay(agents, std::max<size_t>(1, iterations / 100)); } });
+    for (bool useFixed : { false, true }) {
+        cases.push_back({ useFixed ? "World/fixed/production" : "World/dynamic/production", [=] { return benchWorldProduction(useFixed, iterations); } });
+        cases.push_back({ useFixed ? "World/fixed/lp" : "World/dynamic/lp", [=] { return benchWorldLp(useFixed, iterations); } });
+        cases.push_back({ useFixed ? "World/fixed/prices" : "World/dynamic/prices", [=] { return benchWorldPrices(useFixed, iterations); } });
+    }
+    for (bool unshare : { false, true }) {
+        cases.push_back({ std::string(unshare ? "World/copy" : "World/fork") + "/factories=10000",
+                          [=] { return benchWorldFork(10000, unshare, std::max<size_t>(1, iterations / 20)); } });
+    }
+    cases.push_back({ "World/whatif/days=3", [=] { return benchWorldWhatIf(std::max<size_t>(1, iterations / 10)); } });
+    cases.push_back({ "initializeSimulation", [=] { return benchInitialize(std::max<size_t>(1, iterations / 10)); } });
+    for (int size : { 100, 10000 })
+        cases.push_back({ "Production/max/size=" + std::to_string(size), [=] { return benchMaxProducible(size, std::max<size_t>(1, iterations / 20)); } });
+    for (int size : { 100, 10000 })
+        cases.push_back({ "Prices/update/size=" + std::to_string(size), [=] { return benchPriceUpdate(size, std::max<size_t>(1, iterations / 20)); } });
+    for (int size : { 1000, 50000 })
+        cases.push_back({ "Scenario/parse/size=" + std::to_string(size), [=] { return benchScenarioParse(size, std::max<size_t>(1, iterations / (size / 20))); } });
+
+    // With --json - the JSON owns stdout; the table goes to stderr.
+    std::ostream& table = options.jsonPath == "-" ? std::cerr : std::cout;
+    table << std::left << std::setw(32) << "benchmark" << std::right
+        << std::setw(10) << "iters"
+        << std::setw(14) << "ns/op"
+        << std::setw(12) << "p50"
+        << std::setw(12) << "p90"
+        << std::setw(12) << "p99"
+        << std::setw(14) << "max" << "\n";
+    table << std::string(106, '-') << "\n";
+
+    std::vector<BenchResult> results;
+    for (const auto& bench : cases) {
+        if (!options.filter.empty() && bench.name.find(options.filter) == std::string::npos)
+            continue;
+        results.push_back(bench.run());
+        printResult(table, results.back());
+    }
+
+    if (!options.jsonPath.empty()) {
+        if (options.jsonPath == "-") {
+            writeJson(std::cout, results);
+        }
+        else {
+            std::ofstream out(options.jsonPath);
+            if (!out) {
+                std::cerr << "Cannot write " << options.jsonPath << "\n";
+                return 1;
+            }
+            writeJson(out, results);
+        }
+    }
+    return 0;
+}
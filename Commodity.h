@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 #include <utility>
+#include "Price.h"
 
 enum class CommodityType {
     Resource,  // Raw materials that can only be bought/sold.
@@ -10,15 +11,15 @@ enum class CommodityType {
 
 struct Equipment {
     int id;                // Unique equipment type identifier.
-    float price;
+    Price price;
     int output_rate;         // Per Day.
-    float operational_cost;  // Per Day.
+    Price operational_cost;  // Per Day.
 };
 
 struct Commodity {
     int id;
     std::string name;   // Human-readable name.
-    float price;
+    Price price;
     CommodityType type;
     // Production recipe  a list of required commodity IDs and the quantity needed.
     // This allows a product to require either resources or other commodities.
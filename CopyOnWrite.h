@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// A vector whose copies share one buffer until one of them is changed. Reads go through
+// the const interface below; changes go through write(), which first gives this copy a
+// buffer of its own if any other copy still shares it. Copying is a reference count
+// increment, so a copied world (see forkWorld) only pays for the parts it changes.
+//
+// Copies may be read and written from different threads, each copy by one thread at a
+// time: the buffer a copy writes to is never visible to another copy.
+template <typename T>
+class CowVector {
+public:
+    using value_type = T;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    CowVector() = default;
+    CowVector(std::vector<T> values) : data(std::make_shared<std::vector<T>>(std::move(values))) {}
+
+    const std::vector<T>& read() const { return data ? *data : none(); }
+    operator const std::vector<T>&() const { return read(); }
+
+    size_t size() const { return data ? data->size() : 0; }
+    bool empty() const { return size() == 0; }
+    const_iterator begin() const { return read().begin(); }
+    const_iterator end() const { return read().end(); }
+    const T& operator[](size_t i) const { return read()[i]; }
+    const T& front() const { return read().front(); }
+    const T& back() const { return read().back(); }
+
+    // The vector to change, unshared first if needed. Don't keep the reference across a
+    // copy of this vector: the copy would see the changes made through it.
+    std::vector<T>& write() {
+        if (!data) {
+            data = std::make_shared<std::vector<T>>();
+        }
+        else if (data.use_count() != 1) {
+            data = std::make_shared<std::vector<T>>(*data);
+        }
+        else {
+            // The last other owner may have just let go from another thread; make sure its
+            // reads are done before this one writes.
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *data;
+    }
+
+    // True if this copy shares its buffer with another one.
+    bool shared() const { return data && data.use_count() != 1; }
+
+private:
+    static const std::vector<T>& none() {
+        static const std::vector<T> empty;
+        return empty;
+    }
+
+    std::shared_ptr<std::vector<T>> data;   // Null while empty and never written.
+};
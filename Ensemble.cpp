@@ -0,0 +1,171 @@
+#include "Ensemble.h"
+#include "Initialization.h"
+#include "Scenario.h"
+#include "Simulation.h"
+#include "ThreadPool.h"
+#include "Log.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+
+namespace {
+    // The per-day series produced by one run before it is folded into the aggregates.
+    struct RunSeries {
+        std::string error;   // Set if the run could not start; it has no series then.
+        std::vector<double> priceIndex;
+        std::vector<std::vector<double>> aiBalances;
+    };
+
+    double priceIndex(const SimulationWorld& world, const std::vector<Price>& initialPrices) {
+        if (world.resourceCatalog.empty())
+            return 1.0;
+        double total = 0.0;
+        for (size_t i = 0; i < world.resourceCatalog.size(); i++)
+            total += static_cast<double>(world.resourceCatalog[i].price) / initialPrices[i];
+        return total / world.resourceCatalog.size();
+    }
+
+    RunSeries simulateRun(unsigned int seed, const EnsembleConfig& config) {
+        TRACE_SCOPE_ARG("ensemble run", "seed", seed);
+        int days = config.days;
+        RunSeries series;
+        SimulationWorld world;
+        if (config.scenarioText.empty()) {
+            world = initializeSimulation(seed);
+        }
+        else {
+            // Every run shares the catalogs and starting factories; the seed varies the rest.
+            std::string error;
+            if (!parseScenario(config.scenarioText.data(), config.scenarioText.size(), seed, world, error)) {
+                series.error = error;
+                return series;
+            }
+        }
+        AgentPopulation agents(config.agentMix);
+        EventSimulation simulation(world, agents, config.intraday);
+
+        std::vector<Price> initialPrices;
+        for (const auto& res : world.resourceCatalog)
+            initialPrices.push_back(res.price);
+
+        series.priceIndex.reserve(days);
+        series.aiBalances.reserve(days);
+        for (int day = 1; day <= days; day++) {
+            TRACE_SCOPE_ARG("day", "day", day);
+            simulation.runDay(day);
+            series.priceIndex.push_back(priceIndex(world, initialPrices));
+            std::vector<double> balances;
+            for (const auto& factory : world.aiFactories)
+                balances.push_back(priceToDouble(factory.balance));
+            series.aiBalances.push_back(balances);
+        }
+        return series;
+    }
+}
+
+EnsembleResults runEnsemble(const EnsembleConfig& config) {
+    EnsembleResults results;
+    results.config = config;
+    results.priceIndexByDay.resize(config.days);
+    results.aiBalanceByDay.resize(config.days);
+    // The quantile estimates depend on insertion order, so runs are folded in seed order.
+    // A run that finishes early waits in 'finished' until every run before it has been
+    // folded; each series is freed as soon as it is folded.
+    std::mutex foldMutex;
+    std::map<int, RunSeries> finished;
+    int nextToFold = 0;
+    auto fold = [&](const RunSeries& series) {
+        if (!series.error.empty()) {
+            if (results.failedRuns++ == 0)
+                results.error = series.error;
+            return;
+        }
+        for (int d = 0; d < config.days; d++) {
+            results.priceIndexByDay[d].add(series.priceIndex[d]);
+            for (double balance : series.aiBalances[d])
+                results.aiBalanceByDay[d].add(balance);
+        }
+    };
+
+    MetricsSnapshot before = Metrics::snapshot();
+    auto start = std::chrono::steady_clock::now();
+    {
+        ThreadPool pool(config.threads);
+        for (int run = 0; run < config.runs; run++) {
+            unsigned int seed = config.baseSeed + run;
+            pool.submit([&, run, seed] {
+                // Ensemble worlds run silently; the console belongs to the summary.
+                setLogEnabled(false);
+                RunSeries series = simulateRun(seed, config);
+                std::lock_guard<std::mutex> lock(foldMutex);
+                finished.emplace(run, std::move(series));
+                for (auto next = finished.begin(); next != finished.end() && next->first == nextToFold;
+                     next = finished.erase(next), nextToFold++)
+                    fold(next->second);
+            });
+        }
+        pool.wait();
+    }
+    results.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    MetricsSnapshot after = Metrics::snapshot();
+    results.lpSolves = after.phases[static_cast<int>(MetricPhase::LpSolve)].count() -
+        before.phases[static_cast<int>(MetricPhase::LpSolve)].count();
+    int hits = static_cast<int>(MetricCounter::PlanBudgetHits);
+    results.planBudgetHits = after.counters[hits] - before.counters[hits];
+    return results;
+}
+
+void printEnsembleSummary(const EnsembleResults& results, std::ostream& out) {
+    const EnsembleConfig& config = results.config;
+    out << "\n===== Ensemble: " << config.runs << " runs x " << config.days << " days (seeds "
+        << config.baseSeed << ".." << config.baseSeed + config.runs - 1 << ") =====\n";
+    out << std::fixed << std::setprecision(3);
+    out << std::setw(5) << "Day"
+        << " | " << std::setw(28) << "Price index p10 / p50 / p90"
+        << " | " << std::setw(36) << "AI balance p10 / p50 / p90" << "\n";
+    out << std::string(76, '-') << "\n";
+    for (int d = 0; d < config.days; d++) {
+        const EnsembleDistribution& price = results.priceIndexByDay[d];
+        const EnsembleDistribution& balance = results.aiBalanceByDay[d];
+        out << std::setw(5) << d + 1
+            << " | " << std::setw(8) << price.p10.value() << " " << std::setw(8) << price.p50.value()
+            << " " << std::setw(8) << price.p90.value()
+            << "   | " << std::setprecision(1) << std::setw(11) << balance.p10.value()
+            << " " << std::setw(11) << balance.p50.value() << " " << std::setw(11) << balance.p90.value()
+            << std::setprecision(3) << "\n";
+    }
+    if (results.failedRuns > 0) {
+        out << results.failedRuns << " of " << config.runs << " runs failed and were skipped: "
+            << results.error << "\n";
+    }
+    out << std::setprecision(2) << "Elapsed: " << results.elapsedSeconds << " s ("
+        << (results.elapsedSeconds > 0 ? config.runs * config.days / results.elapsedSeconds : 0.0)
+        << " world-days/s)\n";
+    const PlanningBudget& budget = config.intraday.planning;
+    if (budget.perFactory.count() > 0 || budget.perDay.count() > 0) {
+        out << "Planning budget hit in " << results.planBudgetHits << " of " << results.lpSolves
+            << " LP solves.\n";
+    }
+}
+
+bool writeEnsembleCsv(const EnsembleResults& results, const std::string& path) {
+    std::ofstream csv(path);
+    if (!csv)
+        return false;
+    csv << "day,price_index_mean,price_index_min,price_index_p10,price_index_p50,price_index_p90,price_index_max,"
+        << "ai_balance_mean,ai_balance_min,ai_balance_p10,ai_balance_p50,ai_balance_p90,ai_balance_max\n";
+    for (size_t d = 0; d < results.priceIndexByDay.size(); d++) {
+        const EnsembleDistribution& price = results.priceIndexByDay[d];
+        const EnsembleDistribution& balance = results.aiBalanceByDay[d];
+        csv << d + 1
+            << "," << price.stats.mean() << "," << price.stats.min() << "," << price.p10.value()
+            << "," << price.p50.value() << "," << price.p90.value() << "," << price.stats.max()
+            << "," << balance.stats.mean() << "," << balance.stats.min() << "," << balance.p10.value()
+            << "," << balance.p50.value() << "," << balance.p90.value() << "," << balance.stats.max() << "\n";
+    }
+    return static_cast<bool>(csv);
+}
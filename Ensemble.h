@@ -0,0 +1,61 @@
+#pragma once
+#include <ostream>
+#include <string>
+#include <vector>
+#include "StreamingStats.h"
+#include "Simulation.h"
+
+// Monte Carlo ensemble: many independent, seeded worlds stepped concurrently.
+struct EnsembleConfig {
+    int runs = 100;              // Number of independent worlds.
+    int days = 30;               // Days simulated per world.
+    unsigned int baseSeed = 1;   // Run i uses seed baseSeed + i.
+    unsigned int threads = 0;    // Worker threads; 0 = hardware concurrency.
+    IntradayConfig intraday;     // Event-queue settings shared by every run.
+    AgentMix agentMix;           // Behaviours of the AI factories.
+    std::string scenarioText;    // Scenario file contents (Scenario.h) used by every run;
+                                 // empty = randomly generated worlds.
+};
+
+// Cross-run distribution of one quantity on one day.
+struct EnsembleDistribution {
+    RunningStats stats;
+    P2Quantile p10{ 0.10 };
+    P2Quantile p50{ 0.50 };
+    P2Quantile p90{ 0.90 };
+
+    void add(double x) {
+        stats.add(x);
+        p10.add(x);
+        p50.add(x);
+        p90.add(x);
+    }
+};
+
+// Aggregates only: no world or per-run series is retained.
+struct EnsembleResults {
+    EnsembleConfig config;
+    // Index [day - 1]. Price index = mean over resources of price / initial price, so runs
+    // with different randomly generated catalogs are comparable.
+    std::vector<EnsembleDistribution> priceIndexByDay;
+    // Index [day - 1]. One sample per AI factory per run.
+    std::vector<EnsembleDistribution> aiBalanceByDay;
+    double elapsedSeconds = 0.0;
+    uint64_t lpSolves = 0;          // Simplex solves over all runs (needs metrics).
+    uint64_t planBudgetHits = 0;    // Of those, solves cut short by the planning budget.
+    int failedRuns = 0;             // Runs whose world could not be built; not in the aggregates.
+    std::string error;              // Why the first of them (by seed) failed.
+};
+
+// Builds config.runs worlds (seeds baseSeed, baseSeed + 1, ...) and steps each one for
+// config.days days on a work-stealing thread pool. Each run's world is freed as soon as
+// it finishes. Its day series is merged into the aggregates in seed order, as soon as
+// every earlier run has been, and then freed too, so results do not depend on the thread
+// count or scheduling. A run whose scenario fails to parse is skipped and counted in
+// failedRuns.
+EnsembleResults runEnsemble(const EnsembleConfig& config);
+
+void printEnsembleSummary(const EnsembleResults& results, std::ostream& out);
+
+// One row per day with the price index and AI balance distributions.
+bool writeEnsembleCsv(const EnsembleResults& results, const std::string& path);
@@ -0,0 +1,23 @@
+#include "EventScheduler.h"
+
+void EventScheduler::schedule(SimEvent event) {
+    if (event.time < clock)
+        event.time = clock;
+    event.sequence = nextSequence++;
+    queue.push(event);
+}
+
+bool EventScheduler::popNext(SimTime until, SimEvent& event) {
+    if (queue.empty() || queue.top().time > until)
+        return false;
+    event = queue.top();
+    queue.pop();
+    clock = event.time;
+    processed++;
+    return true;
+}
+
+void EventScheduler::advanceTo(SimTime time) {
+    if (time > clock)
+        clock = time;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <vector>
+#include "Market.h"
+
+// Simulation time in ticks since the start of day 1. A day is divided into one-second ticks.
+using SimTime = int64_t;
+constexpr SimTime TICKS_PER_DAY = 24 * 60 * 60;
+
+enum class EventType {
+    OrderArrival,   // An outside trader's order reaches the market.
+    OrderExpiry,    // A resting order's lifetime ends; it is cancelled if still open.
+    AgentWakeup,    // An AI factory takes a turn and schedules its next wakeup.
+    PriceUpdate     // End of day: prices are updated and new resource supply is listed.
+};
+
+struct SimEvent {
+    SimTime time;
+    EventType type;
+    int target;        // AgentWakeup: factory index. OrderExpiry: order id. OrderArrival: product id.
+    OrderType side;    // OrderArrival only.
+    int amount;        // OrderArrival only.
+    Price price;       // OrderArrival only.
+    int ownerId;       // OrderArrival and OrderExpiry.
+    uint64_t sequence; // Assigned by the scheduler; orders events with equal times.
+};
+
+// Priority queue of timestamped events. Events are delivered in time order, and events
+// with equal times in the order they were scheduled, so a run is deterministic.
+class EventScheduler {
+public:
+    // Queues an event. Events in the past are delivered at the current time.
+    void schedule(SimEvent event);
+
+    // Removes the earliest event due at or before 'until' and advances the clock to it.
+    // Returns false, leaving the clock unchanged, if there is none.
+    bool popNext(SimTime until, SimEvent& event);
+
+    // Moves the clock forward to 'time' (never backwards) once the events before it are handled.
+    void advanceTo(SimTime time);
+
+    SimTime now() const { return clock; }
+    size_t pending() const { return queue.size(); }
+    uint64_t processedCount() const { return processed; }
+
+private:
+    struct Later {
+        bool operator()(const SimEvent& a, const SimEvent& b) const {
+            if (a.time != b.time)
+                return a.time > b.time;
+            return a.sequence > b.sequence;
+        }
+    };
+
+    std::priority_queue<SimEvent, std::vector<SimEvent>, Later> queue;
+    SimTime clock = 0;
+    uint64_t nextSequence = 0;
+    uint64_t processed = 0;
+};
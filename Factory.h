@@ -2,19 +2,32 @@
 #include <vector>
 #include <utility>
 #include "Commodity.h"
-#include "Market.h"
+#include "CopyOnWrite.h"
+
+// All units of one equipment type owned by a factory.
+struct EquipmentHolding {
+    Equipment type;
+    int count;
+};
 
 struct Factory {
     int id;
-    float balance;
-    std::vector<Equipment> equipment;
-    // Inventory: a pair of Commodity and its quantity.
-    std::vector<std::pair<Commodity, int>> inventory;
+    Price balance;
+    // Owned equipment, one entry per equipment type. Use addEquipment() to change it so
+    // the cached totals below stay in sync.
+    CowVector<EquipmentHolding> equipment;
+    int capacity = 0;            // Sum of output_rate over every owned unit.
+    Price operatingCost = 0;     // Sum of operational_cost over every owned unit (per day).
+    // Inventory: a pair of Commodity and its quantity. Copies of a factory share their
+    // equipment and inventory until one of them changes it (see CopyOnWrite.h).
+    CowVector<std::pair<Commodity, int>> inventory;
+
+    // Adds 'qty' units of an equipment type and updates the cached totals.
+    void addEquipment(const Equipment& type, int qty);
 
-    // Added member function: returns the maximum number of products that can be produced
-    // based on available resources. (Dummy implementation here.)
-    int optimizeProduction();
+    // Number of owned units of an equipment type.
+    int equipmentCount(int equipmentId) const;
 
-    // Update function (for AI or other use)
-    void update(Market& market);
+    // Daily output of all owned units of an equipment type (count * output_rate).
+    int equipmentCapacity(int equipmentId) const;
 };
@@ -0,0 +1,349 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+#include "Initialization.h"
+#include "Metrics.h"
+#include "SimplexAlgorithm.h"
+
+// GCC fully unrolls short constant-count loops before its vectoriser runs, which leaves
+// them scalar. Marking the hot inner loops below keeps them rolled, so they vectorise.
+#if defined(__GNUC__) && !defined(__clang__)
+#define FIXED_WORLD_VECTOR_LOOP _Pragma("GCC unroll 1")
+#else
+#define FIXED_WORLD_VECTOR_LOOP
+#endif
+
+// The Simplex of SimplexAlgorithm.h over a fixed-size tableau (Rows includes the objective
+// row, Cols the right-hand side), solved in place. Same pivoting rules, so it reaches the
+// same optimum; the sizes are constants, so the scans and the row elimination have fixed
+// trip counts.
+template <size_t Rows, size_t Cols>
+SolveStatus solveFixedSimplex(std::array<std::array<double, Cols>, Rows>& tableau) {
+    METRICS_TIME(MetricPhase::LpSolve);
+    constexpr size_t n = Cols - 1;
+    while (true) {
+        size_t pivotCol = n;
+        double mostNegative = 0;
+        for (size_t j = 0; j < n; j++) {
+            if (tableau[0][j] < mostNegative) {
+                mostNegative = tableau[0][j];
+                pivotCol = j;
+            }
+        }
+        if (pivotCol == n)
+            return SolveStatus::Optimal;
+
+        size_t pivotRow = 0;
+        double minRatio = std::numeric_limits<double>::max();
+        for (size_t i = 1; i < Rows; i++) {
+            if (tableau[i][pivotCol] > 0) {
+                double ratio = tableau[i][n] / tableau[i][pivotCol];
+                if (ratio < minRatio) {
+                    minRatio = ratio;
+                    pivotRow = i;
+                }
+            }
+        }
+        if (pivotRow == 0)
+            return SolveStatus::Unbounded;
+
+        METRICS_COUNT(MetricCounter::LpPivots, 1);
+        std::array<double, Cols>& row = tableau[pivotRow];
+        double pivotVal = row[pivotCol];
+        for (size_t j = 0; j < Cols; j++)
+            row[j] /= pivotVal;
+        for (size_t i = 0; i < Rows; i++) {
+            if (i == pivotRow)
+                continue;
+            double factor = tableau[i][pivotCol];
+            FIXED_WORLD_VECTOR_LOOP
+            for (size_t j = 0; j < Cols; j++)
+                tableau[i][j] -= factor * row[j];
+        }
+    }
+}
+
+// Values of the decision variables after solveFixedSimplex (as Simplex::getSolution).
+template <size_t Rows, size_t Cols>
+void fixedSimplexSolution(const std::array<std::array<double, Cols>, Rows>& tableau,
+                          std::array<double, Cols - 1>& solution) {
+    constexpr size_t n = Cols - 1;
+    for (size_t j = 0; j < n; j++) {
+        solution[j] = 0.0;
+        size_t basicRow = 0;
+        bool isBasic = true;
+        for (size_t i = 1; i < Rows && isBasic; i++) {
+            if (tableau[i][j] == 1 && basicRow == 0)
+                basicRow = i;
+            else if (tableau[i][j] != 0)
+                isBasic = false;
+        }
+        if (isBasic && basicRow != 0)
+            solution[j] = tableau[basicRow][n];
+    }
+}
+
+// Production data of a world whose catalog sizes are known at compile time, e.g. the
+// generated worlds (DefaultFixedWorld). Inventories, the recipe matrix and the LP tableau
+// are std::arrays indexed by slot (resources first, in catalog order, then products), so
+// every loop below has a constant trip count the compiler can unroll and vectorise.
+// load() copies a SimulationWorld in; the dynamic engines (ProductionEngine, AIController,
+// PriceEngine) remain the reference, and market_bench --filter World compares the two.
+template <size_t Resources, size_t Products, size_t Equipments>
+class FixedWorld {
+public:
+    static constexpr size_t Commodities = Resources + Products;
+    // LP rows: resources, intermediate balances, equipment types, blocked products and
+    // total capacity. Rows that do not apply to a factory are left all zero.
+    static constexpr size_t LpRows = Resources + Products + Equipments + Products + 1;
+    using Tableau = std::array<std::array<double, Products + 1>, LpRows + 1>;
+
+    struct FactoryState {
+        int id = 0;
+        std::array<int, Commodities> held{};       // Inventory, by slot.
+        std::array<int, Equipments> equipment{};   // Units owned, by equipment slot.
+    };
+
+    // The day's price inputs, by slot (see PriceEngine).
+    struct DayInputs {
+        std::array<int64_t, Commodities> demand{};
+        std::array<int64_t, Commodities> supply{};
+        std::array<int64_t, Commodities> tradedVolume{};
+        std::array<int64_t, Commodities> tradedNotional{};
+    };
+
+    // Copies the catalogs and AI factories of 'world'. Returns false if its catalog sizes
+    // differ from the template's or a recipe names a commodity or equipment outside them.
+    bool load(const SimulationWorld& world);
+
+    // Units of each product 'factory' could make, each on its own (as
+    // ProductionEngine::maxProducible).
+    void maxProducible(const FactoryState& factory, std::array<int, Products>& units) const;
+
+    // The production LP AIController solves for 'factory'.
+    void buildTableau(const FactoryState& factory, Tableau& tableau) const;
+
+    // Builds and solves that LP. Returns false if it is unbounded.
+    bool plan(const FactoryState& factory, std::array<double, Products>& quantities) const;
+
+    // One daily price update (PriceEngine::computeNextPrices) from the day's inputs.
+    void updatePrices(const DayInputs& inputs);
+
+    std::vector<FactoryState> factories;            // The world's AI factories, in order.
+    std::array<Price, Commodities> prices{};
+
+private:
+    static constexpr double NOT_NEEDED = 1e18;
+
+    int capacity(const FactoryState& factory) const;
+
+    std::array<int, Commodities> ids{};
+    // recipe[p][s]: units of slot s used per unit of product p.
+    std::array<std::array<int, Commodities>, Products> recipe{};
+    // For maxProducible, units of p that held units of s allow are
+    // (held + notNeeded[s][p]) * perUnit[s][p]: 1 / need for ingredients, and a huge value
+    // for other slots. Indexed by slot first, so each slot updates every product's limit
+    // in one branch-free loop over products.
+    std::array<std::array<double, Products>, Commodities> perUnit{};
+    std::array<std::array<double, Products>, Commodities> notNeeded{};
+    std::array<std::array<int, Equipments>, Products> equipmentNeeded{};
+    std::array<int, Equipments> outputRate{};
+    std::array<bool, Products> intermediate{};      // Used in some other product's recipe.
+    std::array<bool, Equipments> equipmentUsed{};   // Required by some product.
+};
+
+// Sized for the worlds initializeSimulation generates.
+using DefaultFixedWorld = FixedWorld<NUM_RESOURCES, NUM_PRODUCTS, NUM_EQUIPMENTS>;
+
+template <size_t Resources, size_t Products, size_t Equipments>
+bool FixedWorld<Resources, Products, Equipments>::load(const SimulationWorld& world) {
+    if (world.resourceCatalog.size() != Resources || world.productCatalog.size() != Products ||
+        world.equipmentCatalog.size() != Equipments)
+        return false;
+
+    std::unordered_map<int, int> slotOf;
+    std::unordered_map<int, int> equipmentSlot;
+    for (size_t r = 0; r < Resources; r++) {
+        ids[r] = world.resourceCatalog[r].id;
+        prices[r] = world.resourceCatalog[r].price;
+        slotOf[ids[r]] = static_cast<int>(r);
+    }
+    for (size_t p = 0; p < Products; p++) {
+        ids[Resources + p] = world.productCatalog[p].id;
+        prices[Resources + p] = world.productCatalog[p].price;
+        slotOf[ids[Resources + p]] = static_cast<int>(Resources + p);
+    }
+    for (size_t e = 0; e < Equipments; e++) {
+        outputRate[e] = world.equipmentCatalog[e].output_rate;
+        equipmentSlot[world.equipmentCatalog[e].id] = static_cast<int>(e);
+    }
+
+    recipe = {};
+    equipmentNeeded = {};
+    intermediate = {};
+    equipmentUsed = {};
+    for (size_t p = 0; p < Products; p++) {
+        const Commodity& prod = world.productCatalog[p];
+        for (const auto& req : prod.recipe) {
+            auto it = slotOf.find(req.first);
+            if (it == slotOf.end())
+                return false;
+            recipe[p][it->second] += req.second;
+            if (it->second >= static_cast<int>(Resources))
+                intermediate[it->second - Resources] = true;
+        }
+        for (const auto& req : prod.requiredEquipment) {
+            auto it = equipmentSlot.find(req.first);
+            if (it == equipmentSlot.end())
+                return false;
+            equipmentNeeded[p][it->second] = req.second;
+            equipmentUsed[it->second] = true;
+        }
+    }
+
+    for (size_t p = 0; p < Products; p++) {
+        for (size_t s = 0; s < Commodities; s++) {
+            bool needed = recipe[p][s] > 0;
+            perUnit[s][p] = needed ? 1.0 / recipe[p][s] : 1.0;
+            notNeeded[s][p] = needed ? 0.0 : NOT_NEEDED;
+        }
+    }
+
+    factories.assign(world.aiFactories.size(), FactoryState());
+    for (size_t f = 0; f < world.aiFactories.size(); f++) {
+        const Factory& factory = world.aiFactories[f];
+        FactoryState& state = factories[f];
+        state.id = factory.id;
+        for (const auto& item : factory.inventory) {
+            auto it = slotOf.find(item.first.id);
+            if (it != slotOf.end())
+                state.held[it->second] += item.second;
+        }
+        for (const auto& holding : factory.equipment) {
+            auto it = equipmentSlot.find(holding.type.id);
+            if (it != equipmentSlot.end())
+                state.equipment[it->second] += holding.count;
+        }
+    }
+    return true;
+}
+
+template <size_t Resources, size_t Products, size_t Equipments>
+int FixedWorld<Resources, Products, Equipments>::capacity(const FactoryState& factory) const {
+    int total = 0;
+    for (size_t e = 0; e < Equipments; e++)
+        total += factory.equipment[e] * outputRate[e];
+    return total;
+}
+
+template <size_t Resources, size_t Products, size_t Equipments>
+void FixedWorld<Resources, Products, Equipments>::maxProducible(const FactoryState& factory,
+                                                                std::array<int, Products>& units) const {
+    int total = capacity(factory);
+    std::array<double, Products> allowed;
+    allowed.fill(NOT_NEEDED);
+    for (size_t s = 0; s < Commodities; s++) {
+        double held = factory.held[s];
+        FIXED_WORLD_VECTOR_LOOP
+        for (size_t p = 0; p < Products; p++) {
+            double made = (held + notNeeded[s][p]) * perUnit[s][p];
+            allowed[p] = made < allowed[p] ? made : allowed[p];
+        }
+    }
+    for (size_t p = 0; p < Products; p++) {
+        // No recipe: not manufacturable. The epsilon absorbs the rounding of 1 / need.
+        int limit = allowed[p] >= NOT_NEEDED / 2
+            ? 0
+            : static_cast<int>(std::floor(std::min<double>(allowed[p], total) + 1e-9));
+        for (size_t e = 0; e < Equipments; e++) {
+            if (equipmentNeeded[p][e] == 0)
+                continue;
+            limit = factory.equipment[e] < equipmentNeeded[p][e]
+                ? 0
+                : std::min(limit, factory.equipment[e] * outputRate[e]);
+        }
+        units[p] = std::max(limit, 0);
+    }
+}
+
+template <size_t Resources, size_t Products, size_t Equipments>
+void FixedWorld<Resources, Products, Equipments>::buildTableau(const FactoryState& factory,
+                                                               Tableau& tableau) const {
+    for (auto& row : tableau)
+        row.fill(0.0);
+    const size_t rhs = Products;
+    // Net revenue, as AIController: a product's price less that of the intermediates it uses.
+    for (size_t p = 0; p < Products; p++) {
+        double profit = priceToDouble(prices[Resources + p]);
+        for (size_t q = 0; q < Products; q++)
+            profit -= recipe[p][Resources + q] * priceToDouble(prices[Resources + q]);
+        tableau[0][p] = -profit;
+    }
+
+    // Resources: sum_p need * x_p <= held.
+    for (size_t r = 0; r < Resources; r++) {
+        for (size_t p = 0; p < Products; p++)
+            tableau[1 + r][p] = recipe[p][r];
+        tableau[1 + r][rhs] = factory.held[r];
+    }
+    // Intermediates: sum_p need * x_p - x_q <= held_q.
+    for (size_t q = 0; q < Products; q++) {
+        if (!intermediate[q])
+            continue;
+        auto& row = tableau[1 + Resources + q];
+        for (size_t p = 0; p < Products; p++)
+            row[p] = recipe[p][Resources + q];
+        row[q] -= 1;
+        row[rhs] = factory.held[Resources + q];
+    }
+    // Equipment types: sum over products requiring e of x_p <= count_e * output_rate_e.
+    // Blocked products (required equipment not owned in full): x_p <= 0.
+    const size_t firstEquipmentRow = 1 + Resources + Products;
+    const size_t firstBlockedRow = firstEquipmentRow + Equipments;
+    for (size_t e = 0; e < Equipments; e++) {
+        if (!equipmentUsed[e])
+            continue;
+        auto& row = tableau[firstEquipmentRow + e];
+        for (size_t p = 0; p < Products; p++)
+            row[p] = equipmentNeeded[p][e] > 0 ? 1.0 : 0.0;
+        row[rhs] = factory.equipment[e] * outputRate[e];
+    }
+    for (size_t p = 0; p < Products; p++) {
+        bool blocked = false;
+        for (size_t e = 0; e < Equipments; e++)
+            blocked |= factory.equipment[e] < equipmentNeeded[p][e];
+        if (blocked)
+            tableau[firstBlockedRow + p][p] = 1;
+    }
+    // Total capacity: sum_p x_p <= capacity.
+    for (size_t p = 0; p < Products; p++)
+        tableau[LpRows][p] = 1;
+    tableau[LpRows][rhs] = capacity(factory);
+}
+
+template <size_t Resources, size_t Products, size_t Equipments>
+bool FixedWorld<Resources, Products, Equipments>::plan(const FactoryState& factory,
+                                                       std::array<double, Products>& quantities) const {
+    Tableau tableau;
+    buildTableau(factory, tableau);
+    if (solveFixedSimplex(tableau) != SolveStatus::Optimal)
+        return false;
+    fixedSimplexSolution(tableau, quantities);
+    return true;
+}
+
+template <size_t Resources, size_t Products, size_t Equipments>
+void FixedWorld<Resources, Products, Equipments>::updatePrices(const DayInputs& inputs) {
+    std::array<Price, Commodities> next;
+    std::array<int64_t, Commodities> denominators;
+    PriceEngine::computeNextPrices(Resources, Commodities, prices, inputs.demand, inputs.supply,
+                                   inputs.tradedVolume, inputs.tradedNotional, denominators, next);
+    prices = next;
+}
@@ -0,0 +1,374 @@
+#include "Gateway.h"
+#include "Log.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    const int MAX_EVENTS = 64;
+    const size_t READ_CHUNK = 64 * 1024;
+    // Upper bound on bytes taken from one session per poll, so a busy client cannot starve the others.
+    const size_t MAX_READ_PER_POLL = 256 * 1024;
+
+    bool makeAddress(const std::string& path, sockaddr_un& address) {
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path))
+            return false;
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        return true;
+    }
+
+    bool setNonBlocking(int fd) {
+        int flags = fcntl(fd, F_GETFL, 0);
+        return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+}
+
+Gateway::Gateway(Market& market, const GatewayConfig& config)
+    : market(market), config(config), listenFd(-1), epollFd(-1),
+      nextOwnerId(config.firstOwnerId), processed(0) {}
+
+Gateway::~Gateway() {
+    close();
+}
+
+bool Gateway::open(const std::string& socketPath) {
+    close();
+    sockaddr_un address;
+    if (!makeAddress(socketPath, address)) {
+        simLog() << "Gateway: socket path too long: " << socketPath << "\n";
+        return false;
+    }
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    epollFd = epoll_create1(0);
+    if (listenFd < 0 || epollFd < 0 || !setNonBlocking(listenFd)) {
+        simLog() << "Gateway: cannot create sockets: " << std::strerror(errno) << "\n";
+        close();
+        return false;
+    }
+    unlink(socketPath.c_str());
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listenFd, SOMAXCONN) != 0) {
+        simLog() << "Gateway: cannot listen on " << socketPath << ": " << std::strerror(errno) << "\n";
+        close();
+        return false;
+    }
+    path = socketPath;
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+    return true;
+}
+
+void Gateway::close() {
+    while (!sessions.empty())
+        disconnect(sessions.begin()->first);
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        listenFd = -1;
+    }
+    if (epollFd >= 0) {
+        ::close(epollFd);
+        epollFd = -1;
+    }
+    if (!path.empty()) {
+        unlink(path.c_str());
+        path.clear();
+    }
+}
+
+int Gateway::poll(int timeoutMs) {
+    if (epollFd < 0)
+        return -1;
+    epoll_event events[MAX_EVENTS];
+    int ready = epoll_wait(epollFd, events, MAX_EVENTS, timeoutMs);
+    if (ready < 0)
+        return errno == EINTR ? 0 : -1;
+
+    uint64_t processedBefore = processed;
+    for (int i = 0; i < ready; i++) {
+        int fd = events[i].data.fd;
+        if (fd == listenFd) {
+            acceptSessions();
+            continue;
+        }
+        auto it = sessions.find(fd);
+        if (it == sessions.end())
+            continue;   // Disconnected earlier in this batch.
+        Session& session = it->second;
+        if (events[i].events & EPOLLIN) {
+            if (!readSession(session)) {
+                disconnect(fd);
+                continue;
+            }
+        }
+        else if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+            disconnect(fd);
+            continue;
+        }
+        if ((events[i].events & EPOLLOUT) && !session.queued) {
+            session.queued = true;
+            dirty.push_back(fd);
+        }
+    }
+
+    // One write per session for everything queued while handling this batch.
+    for (int fd : dirty) {
+        auto it = sessions.find(fd);
+        if (it == sessions.end())
+            continue;
+        it->second.queued = false;
+        if (!flush(it->second))
+            disconnect(fd);
+    }
+    dirty.clear();
+    return static_cast<int>(processed - processedBefore);
+}
+
+void Gateway::acceptSessions() {
+    while (true) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0)
+            return;     // EAGAIN: no more pending connections.
+        if (!setNonBlocking(fd)) {
+            ::close(fd);
+            continue;
+        }
+        Session session;
+        session.fd = fd;
+        session.ownerId = nextOwnerId++;
+        session.wantsWrite = false;
+        session.queued = false;
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        fdByOwner[session.ownerId] = fd;
+        simLog() << "Gateway: session " << session.ownerId << " connected\n";
+        sessions.emplace(fd, std::move(session));
+    }
+}
+
+bool Gateway::readSession(Session& session) {
+    size_t total = 0;
+    while (total < MAX_READ_PER_POLL) {
+        size_t kept = session.input.size();
+        session.input.resize(kept + READ_CHUNK);
+        ssize_t n = read(session.fd, session.input.data() + kept, READ_CHUNK);
+        if (n <= 0) {
+            session.input.resize(kept);
+            if (n == 0)
+                return false;   // Peer closed.
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        session.input.resize(kept + n);
+        total += n;
+
+        // Apply every complete request; keep the trailing partial one for the next read.
+        size_t complete = session.input.size() / sizeof(GatewayRequest);
+        for (size_t i = 0; i < complete; i++) {
+            GatewayRequest request;
+            std::memcpy(&request, session.input.data() + i * sizeof(GatewayRequest), sizeof(request));
+            apply(session, request);
+        }
+        session.input.erase(session.input.begin(), session.input.begin() + complete * sizeof(GatewayRequest));
+    }
+    return true;
+}
+
+void Gateway::apply(Session& session, const GatewayRequest& request) {
+    size_t firstTrade = market.trades.size();
+    GatewayReport report{};
+    report.type = static_cast<uint8_t>(GatewayReportType::Rejected);
+    report.orderId = request.orderId;
+    report.clientTag = request.clientTag;
+
+    switch (static_cast<GatewayRequestType>(request.type)) {
+    case GatewayRequestType::NewOrder:
+        if (request.amount <= 0 || request.side > static_cast<uint8_t>(GatewaySide::Sell))
+            break;
+        report.orderId = request.side == static_cast<uint8_t>(GatewaySide::Buy)
+            ? market.placeBuyOrder(request.productId, request.amount, request.price, session.ownerId)
+            : market.placeSellOrder(request.productId, request.amount, request.price, session.ownerId);
+        report.type = static_cast<uint8_t>(GatewayReportType::Accepted);
+        break;
+    case GatewayRequestType::Cancel:
+        if (market.removeOrder(request.orderId, session.ownerId))
+            report.type = static_cast<uint8_t>(GatewayReportType::Cancelled);
+        break;
+    case GatewayRequestType::Amend:
+        if (market.amendOrder(request.orderId, session.ownerId, request.amount, request.price))
+            report.type = static_cast<uint8_t>(GatewayReportType::Amended);
+        break;
+    }
+    queueReport(session, report);
+    routeFills(firstTrade);
+    processed++;
+}
+
+void Gateway::routeFills(size_t firstTrade) {
+    // Trades stay in market.trades for the Market's owner; only the new ones are inspected here.
+    for (size_t i = firstTrade; i < market.trades.size(); i++) {
+        const Trade& trade = market.trades[i];
+        GatewayReport fill{};
+        fill.type = static_cast<uint8_t>(GatewayReportType::Fill);
+        fill.productId = trade.productId;
+        fill.amount = trade.amount;
+        fill.price = trade.price;
+        auto buyer = fdByOwner.find(trade.buyerId);
+        if (buyer != fdByOwner.end()) {
+            fill.side = static_cast<uint8_t>(GatewaySide::Buy);
+            fill.orderId = trade.buyOrderId;
+            queueReport(sessions[buyer->second], fill);
+        }
+        auto seller = fdByOwner.find(trade.sellerId);
+        if (seller != fdByOwner.end()) {
+            fill.side = static_cast<uint8_t>(GatewaySide::Sell);
+            fill.orderId = trade.sellOrderId;
+            queueReport(sessions[seller->second], fill);
+        }
+    }
+}
+
+void Gateway::queueReport(Session& session, const GatewayReport& report) {
+    const char* bytes = reinterpret_cast<const char*>(&report);
+    session.output.insert(session.output.end(), bytes, bytes + sizeof(report));
+    if (!session.queued) {
+        session.queued = true;
+        dirty.push_back(session.fd);
+    }
+}
+
+bool Gateway::flush(Session& session) {
+    size_t written = 0;
+    while (written < session.output.size()) {
+        ssize_t n = send(session.fd, session.output.data() + written, session.output.size() - written, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            return false;
+        }
+        written += n;
+    }
+    session.output.erase(session.output.begin(), session.output.begin() + written);
+    if (session.output.size() > config.maxPendingBytes) {
+        simLog() << "Gateway: session " << session.ownerId << " is not reading its reports\n";
+        return false;
+    }
+
+    // Wait for EPOLLOUT only while something is left to send.
+    bool wantsWrite = !session.output.empty();
+    if (wantsWrite != session.wantsWrite) {
+        epoll_event event{};
+        event.events = wantsWrite ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+        event.data.fd = session.fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, session.fd, &event);
+        session.wantsWrite = wantsWrite;
+    }
+    return true;
+}
+
+void Gateway::disconnect(int fd) {
+    auto it = sessions.find(fd);
+    if (it == sessions.end())
+        return;
+    int ownerId = it->second.ownerId;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    fdByOwner.erase(ownerId);
+    sessions.erase(it);
+    simLog() << "Gateway: session " << ownerId << " disconnected\n";
+
+    if (config.cancelOnDisconnect) {
+        std::vector<int> resting;
+        for (const auto& entry : market.books) {
+            for (const auto& order : entry.second) {
+                if (order.ownerId == ownerId)
+                    resting.push_back(order.id);
+            }
+        }
+        for (int orderId : resting)
+            market.removeOrder(orderId, ownerId);
+    }
+}
+
+GatewayClient::GatewayClient() : fd(-1) {}
+
+GatewayClient::~GatewayClient() {
+    disconnect();
+}
+
+bool GatewayClient::connect(const std::string& socketPath) {
+    disconnect();
+    sockaddr_un address;
+    if (!makeAddress(socketPath, address))
+        return false;
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return false;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        disconnect();
+        return false;
+    }
+    return true;
+}
+
+void GatewayClient::disconnect() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    pending.clear();
+}
+
+bool GatewayClient::send(const GatewayRequest* requests, size_t count) {
+    const char* bytes = reinterpret_cast<const char*>(requests);
+    size_t size = count * sizeof(GatewayRequest);
+    size_t written = 0;
+    while (written < size) {
+        ssize_t n = ::send(fd, bytes + written, size - written, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+
+size_t GatewayClient::receive(GatewayReport* reports, size_t maxReports) {
+    if (fd < 0 || maxReports == 0)
+        return 0;
+    while (pending.size() < sizeof(GatewayReport)) {
+        size_t kept = pending.size();
+        // Read no more than the caller can take, so leftover bytes stay small.
+        size_t room = maxReports * sizeof(GatewayReport) - kept;
+        pending.resize(kept + room);
+        ssize_t n = read(fd, pending.data() + kept, room);
+        if (n <= 0) {
+            pending.resize(kept);
+            if (n < 0 && errno == EINTR)
+                continue;
+            return 0;
+        }
+        pending.resize(kept + n);
+    }
+    size_t count = std::min(maxReports, pending.size() / sizeof(GatewayReport));
+    std::memcpy(reports, pending.data(), count * sizeof(GatewayReport));
+    pending.erase(pending.begin(), pending.begin() + count * sizeof(GatewayReport));
+    return count;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "GatewayProtocol.h"
+#include "Market.h"
+
+// Order-entry gateway: lets processes on the same host trade against a Market over a
+// Unix domain stream socket using the fixed-size records in GatewayProtocol.h.
+// Linux only (epoll).
+//
+// The gateway is single-threaded: poll() waits for socket activity, reads everything
+// available from each ready session, applies the requests to the Market in arrival
+// order, then writes each session's queued reports with a single write. The Market must
+// only be touched from the thread that calls poll().
+//
+// Each session is a Market participant with its own ownerId, assigned on connect.
+
+struct GatewayConfig {
+    int firstOwnerId = 100000;        // Sessions get ownerIds firstOwnerId, firstOwnerId + 1, ...
+    bool cancelOnDisconnect = true;   // Remove a session's resting orders when it disconnects.
+    size_t maxPendingBytes = 4 << 20; // Disconnect a session whose unsent reports exceed this.
+};
+
+class Gateway {
+public:
+    explicit Gateway(Market& market, const GatewayConfig& config = GatewayConfig());
+    ~Gateway();
+
+    Gateway(const Gateway&) = delete;
+    Gateway& operator=(const Gateway&) = delete;
+
+    // Creates the listening socket at 'socketPath' (replacing a stale one). Returns false on error.
+    bool open(const std::string& socketPath);
+
+    // Waits up to 'timeoutMs' (-1 = forever) for activity and handles it.
+    // Returns the number of requests applied, or -1 if the gateway is not open.
+    int poll(int timeoutMs);
+
+    // Disconnects every session and removes the socket.
+    void close();
+
+    size_t sessionCount() const { return sessions.size(); }
+    uint64_t requestsProcessed() const { return processed; }
+
+private:
+    struct Session {
+        int fd;
+        int ownerId;
+        std::vector<char> input;   // Bytes of an incomplete request left from the last read.
+        std::vector<char> output;  // Reports not yet written.
+        bool wantsWrite;           // Registered for EPOLLOUT because a write was partial.
+        bool queued;               // Listed in 'dirty'.
+    };
+
+    void acceptSessions();
+    bool readSession(Session& session);
+    void apply(Session& session, const GatewayRequest& request);
+    void queueReport(Session& session, const GatewayReport& report);
+    void routeFills(size_t firstTrade);
+    bool flush(Session& session);
+    void disconnect(int fd);
+
+    Market& market;
+    GatewayConfig config;
+    std::string path;
+    int listenFd;
+    int epollFd;
+    int nextOwnerId;
+    std::unordered_map<int, Session> sessions;   // By socket fd.
+    std::unordered_map<int, int> fdByOwner;      // ownerId -> socket fd, for routing fills.
+    std::vector<int> dirty;                      // Sessions with reports queued during this poll.
+    uint64_t processed;
+};
+
+// Blocking client side of the protocol, for strategy processes, tools and benchmarks.
+class GatewayClient {
+public:
+    GatewayClient();
+    ~GatewayClient();
+
+    GatewayClient(const GatewayClient&) = delete;
+    GatewayClient& operator=(const GatewayClient&) = delete;
+
+    bool connect(const std::string& socketPath);
+    void disconnect();
+
+    // Writes all 'count' requests (one write when the socket buffer allows).
+    bool send(const GatewayRequest* requests, size_t count);
+
+    // Blocks until at least one report arrives, then returns as many complete reports as
+    // are available, up to 'maxReports'. Returns 0 if the connection closed.
+    size_t receive(GatewayReport* reports, size_t maxReports);
+
+private:
+    int fd;
+    std::vector<char> pending;  // Bytes of an incomplete report.
+};
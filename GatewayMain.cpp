@@ -0,0 +1,100 @@
+// Runs a simulated world as a local exchange: strategy processes connect to the gateway
+// socket and trade against the Market while the AI factories keep trading in the background.
+//
+// Usage: market_gateway [--socket PATH] [--seed S] [--day-ms N] [--intraday-orders N] [--feed NAME]
+//
+// --day-ms N advances the world one simulated day every N milliseconds of wall time
+// (0 = never, the book only changes through the gateway). --feed NAME also publishes the
+// book to shared memory for market_feed_reader. Stop with Ctrl+C.
+#include "Gateway.h"
+#include "Initialization.h"
+#include "AgentStrategies.h"
+#include "Simulation.h"
+#include "Log.h"
+#include "MarketDataFeed.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+    volatile std::sig_atomic_t stopRequested = 0;
+
+    void requestStop(int) {
+        stopRequested = 1;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string socketPath = "/tmp/market_sim.sock";
+    unsigned int seed = 1;
+    int dayMs = 1000;
+    IntradayConfig intraday;
+    std::string feedName;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--socket")
+            socketPath = argv[i + 1];
+        else if (arg == "--seed")
+            seed = static_cast<unsigned int>(std::strtoul(argv[i + 1], nullptr, 10));
+        else if (arg == "--day-ms")
+            dayMs = std::atoi(argv[i + 1]);
+        else if (arg == "--feed")
+            feedName = argv[i + 1];
+        else if (arg == "--intraday-orders")
+            intraday.orderArrivalsPerDay = std::atoi(argv[i + 1]);
+        else
+            std::cout << "Ignoring unknown option " << arg << "\n";
+    }
+
+    // Per-order narration would dominate the gateway's cost.
+    setLogEnabled(false);
+    SimulationWorld world = initializeSimulation(seed);
+    MarketDataFeed feed;
+    if (!feedName.empty()) {
+        if (!feed.create(feedName, maxCommodityId(world) + 1)) {
+            std::cout << "Cannot create market data feed " << feedName << "\n";
+            return 1;
+        }
+        world.market.feed = &feed;
+    }
+    AgentPopulation agents;
+    EventSimulation simulation(world, agents, intraday);
+    Gateway gateway(world.market);
+    if (!gateway.open(socketPath)) {
+        std::cout << "Cannot listen on " << socketPath << "\n";
+        return 1;
+    }
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+    std::cout << "Gateway listening on " << socketPath << " (seed " << seed << ")\n";
+
+    using Clock = std::chrono::steady_clock;
+    int day = 0;
+    Clock::time_point nextDay = Clock::now() + std::chrono::milliseconds(dayMs);
+    while (!stopRequested) {
+        int timeoutMs = 100;
+        if (dayMs > 0) {
+            auto untilDay = std::chrono::duration_cast<std::chrono::milliseconds>(nextDay - Clock::now()).count();
+            timeoutMs = static_cast<int>(std::max<long long>(0, std::min<long long>(timeoutMs, untilDay)));
+        }
+        if (gateway.poll(timeoutMs) < 0)
+            break;
+        if (dayMs > 0 && Clock::now() >= nextDay) {
+            simulation.runDay(++day);
+            nextDay += std::chrono::milliseconds(dayMs);
+            std::cout << "Day " << day << ": " << gateway.sessionCount() << " sessions, "
+                << gateway.requestsProcessed() << " requests so far\n";
+        }
+        else if (dayMs == 0) {
+            // Without simulated days nothing else drains the trade records.
+            world.market.trades.clear();
+        }
+    }
+
+    gateway.close();
+    std::cout << "Gateway stopped after " << gateway.requestsProcessed() << " requests.\n";
+    return 0;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include "Price.h"
+
+// Wire format of the order-entry gateway. Every message is a fixed 32-byte record in host
+// byte order (client and gateway run on the same machine), so a read of N bytes holds
+// N / 32 complete messages and no length prefix or parsing is needed.
+
+enum class GatewayRequestType : uint8_t {
+    NewOrder = 1,   // side, productId, amount, price.
+    Cancel = 2,     // orderId.
+    Amend = 3       // orderId, amount (new remaining quantity), price.
+};
+
+enum class GatewayReportType : uint8_t {
+    Accepted = 1,   // NewOrder placed; orderId is the id assigned by the Market.
+    Cancelled = 2,
+    Amended = 3,
+    Rejected = 4,   // Malformed request, or the order does not exist or belongs to another session.
+    Fill = 5        // One execution against one of the session's orders (sent for both sides).
+};
+
+enum class GatewaySide : uint8_t { Buy = 0, Sell = 1 };
+
+struct GatewayRequest {
+    uint8_t type;       // GatewayRequestType.
+    uint8_t side;       // GatewaySide; NewOrder only.
+    uint16_t reserved;
+    int32_t productId;
+    int64_t price;      // Price ticks (Price.h).
+    int32_t amount;
+    int32_t orderId;
+    uint64_t clientTag; // Echoed in the Accepted/Cancelled/Amended/Rejected report.
+};
+
+struct GatewayReport {
+    uint8_t type;       // GatewayReportType.
+    uint8_t side;       // GatewaySide of the order; Fill only.
+    uint16_t reserved;
+    int32_t orderId;
+    int64_t price;      // Fill: execution price in ticks.
+    int32_t productId;  // Fill only.
+    int32_t amount;     // Fill: quantity traded.
+    uint64_t clientTag; // Tag of the request this answers; 0 for fills.
+};
+
+static_assert(sizeof(GatewayRequest) == 32, "GatewayRequest is a fixed 32-byte wire record");
+static_assert(sizeof(GatewayReport) == 32, "GatewayReport is a fixed 32-byte wire record");
@@ -0,0 +1,286 @@
+#include "HistoryStore.h"
+#include "Log.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    std::string columnPath(const std::string& directory, const std::string& table, const std::string& column) {
+        return (std::filesystem::path(directory) / (table + "." + column + ".col")).string();
+    }
+
+    HistoryColumnHeader makeHeader(uint32_t valueSize, uint32_t flags, uint64_t rowCount) {
+        HistoryColumnHeader header{};
+        header.magic = HISTORY_MAGIC;
+        header.version = HISTORY_VERSION;
+        header.valueSize = valueSize;
+        header.flags = flags;
+        header.rowCount = rowCount;
+        return header;
+    }
+
+    // Totals of one commodity's trades in a day.
+    struct TradeAggregate {
+        int trades = 0;
+        int64_t volume = 0;
+        int64_t notional = 0;   // Sum of price * amount, in ticks.
+        Price high = 0;
+        Price low = 0;
+    };
+}
+
+HistoryWriter::HistoryWriter() : failed(false) {}
+
+HistoryWriter::~HistoryWriter() {
+    close();
+}
+
+bool HistoryWriter::open(const std::string& path) {
+    close();
+    std::error_code error;
+    std::filesystem::create_directories(path, error);
+    if (error)
+        return false;
+    directory = path;
+    failed = false;
+    addTable("prices", { { "day", 4, 0 }, { "commodity", 4, 0 }, { "type", 4, 0 },
+                         { "price", 8, HISTORY_COLUMN_PRICE } });
+    addTable("trades", { { "day", 4, 0 }, { "commodity", 4, 0 }, { "trades", 4, 0 }, { "volume", 8, 0 },
+                         { "vwap", 8, HISTORY_COLUMN_PRICE }, { "high", 8, HISTORY_COLUMN_PRICE },
+                         { "low", 8, HISTORY_COLUMN_PRICE } });
+    addTable("factories", { { "day", 4, 0 }, { "factory", 4, 0 }, { "balance", 8, HISTORY_COLUMN_PRICE },
+                            { "capacity", 4, 0 }, { "operatingCost", 8, HISTORY_COLUMN_PRICE } });
+    addTable("inventory", { { "day", 4, 0 }, { "factory", 4, 0 }, { "commodity", 4, 0 },
+                            { "quantity", 4, 0 } });
+    if (failed) {
+        simLog() << "HistoryWriter: cannot create column files in " << path << "\n";
+        close();
+        return false;
+    }
+    return true;
+}
+
+void HistoryWriter::close() {
+    for (auto& entry : tables) {
+        flush(*entry.second);
+        for (Column& column : entry.second->columns)
+            column.file.close();
+    }
+    tables.clear();
+}
+
+HistoryWriter::Table& HistoryWriter::addTable(const std::string& name, const std::vector<ColumnSpec>& layout) {
+    std::unique_ptr<Table> table(new Table());
+    for (const ColumnSpec& spec : layout) {
+        table->columns.emplace_back();
+        Column& column = table->columns.back();
+        column.name = spec.name;
+        column.valueSize = spec.valueSize;
+        column.flags = spec.flags;
+        column.pending.reserve(HISTORY_CHUNK_ROWS * spec.valueSize);
+        column.file.open(columnPath(directory, name, spec.name), std::ios::binary | std::ios::trunc);
+        HistoryColumnHeader header = makeHeader(spec.valueSize, spec.flags, 0);
+        column.file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!column.file)
+            failed = true;
+    }
+    Table& result = *table;
+    tables[name] = std::move(table);
+    return result;
+}
+
+void HistoryWriter::appendRow(Table& table, const std::vector<int64_t>& values) {
+    for (size_t c = 0; c < table.columns.size(); c++) {
+        Column& column = table.columns[c];
+        if (column.valueSize == 4) {
+            int32_t value = static_cast<int32_t>(values[c]);
+            column.pending.insert(column.pending.end(), reinterpret_cast<const char*>(&value),
+                                  reinterpret_cast<const char*>(&value) + 4);
+        }
+        else {
+            int64_t value = values[c];
+            column.pending.insert(column.pending.end(), reinterpret_cast<const char*>(&value),
+                                  reinterpret_cast<const char*>(&value) + 8);
+        }
+    }
+    if (++table.pendingRows == HISTORY_CHUNK_ROWS)
+        flush(table);
+}
+
+void HistoryWriter::flush(Table& table) {
+    if (table.pendingRows == 0)
+        return;
+    table.rowCount += table.pendingRows;
+    table.pendingRows = 0;
+    for (Column& column : table.columns) {
+        // Values first, then the row count that makes them visible.
+        column.file.seekp(0, std::ios::end);
+        column.file.write(column.pending.data(), column.pending.size());
+        column.file.flush();
+        HistoryColumnHeader header = makeHeader(column.valueSize, column.flags, table.rowCount);
+        column.file.seekp(0);
+        column.file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        column.file.flush();
+        column.pending.clear();
+    }
+}
+
+void HistoryWriter::recordDay(const SimulationWorld& world, int day) {
+    if (!isOpen())
+        return;
+
+    Table& prices = *tables["prices"];
+    for (const auto& res : world.resourceCatalog)
+        appendRow(prices, { day, res.id, static_cast<int>(res.type), res.price });
+    for (const auto& prod : world.productCatalog)
+        appendRow(prices, { day, prod.id, static_cast<int>(prod.type), prod.price });
+
+    std::map<int, TradeAggregate> aggregates;
+    for (const Trade& trade : world.market.trades) {
+        TradeAggregate& agg = aggregates[trade.productId];
+        if (agg.trades == 0 || trade.price > agg.high)
+            agg.high = trade.price;
+        if (agg.trades == 0 || trade.price < agg.low)
+            agg.low = trade.price;
+        agg.trades++;
+        agg.volume += trade.amount;
+        agg.notional += trade.price * trade.amount;
+    }
+    Table& trades = *tables["trades"];
+    for (const auto& entry : aggregates) {
+        const TradeAggregate& agg = entry.second;
+        Price vwap = agg.volume > 0 ? (agg.notional + agg.volume / 2) / agg.volume : 0;
+        appendRow(trades, { day, entry.first, agg.trades, agg.volume, vwap, agg.high, agg.low });
+    }
+
+    Table& factories = *tables["factories"];
+    Table& inventory = *tables["inventory"];
+    auto recordFactory = [&](const Factory& factory) {
+        appendRow(factories, { day, factory.id, factory.balance, factory.capacity, factory.operatingCost });
+        for (const auto& item : factory.inventory)
+            appendRow(inventory, { day, factory.id, item.first.id, item.second });
+    };
+    recordFactory(world.playerFactory);
+    for (const auto& factory : world.aiFactories)
+        recordFactory(factory);
+}
+
+int64_t HistoryColumnView::operator[](size_t i) const {
+    if (valueSize == 4) {
+        int32_t value;
+        std::memcpy(&value, data + i * 4, 4);
+        return value;
+    }
+    int64_t value;
+    std::memcpy(&value, data + i * 8, 8);
+    return value;
+}
+
+HistoryReader::HistoryReader() {}
+
+HistoryReader::~HistoryReader() {
+    close();
+}
+
+bool HistoryReader::open(const std::string& path) {
+    close();
+#if defined(_WIN32)
+    return false;
+#else
+    std::error_code error;
+    if (!std::filesystem::is_directory(path, error))
+        return false;
+    directory = path;
+    return true;
+#endif
+}
+
+void HistoryReader::close() {
+#if !defined(_WIN32)
+    for (auto& entry : mappings) {
+        if (entry.second.region)
+            munmap(entry.second.region, entry.second.size);
+    }
+#endif
+    mappings.clear();
+    directory.clear();
+}
+
+const HistoryReader::Mapping* HistoryReader::map(const std::string& table, const std::string& column) {
+    if (directory.empty())
+        return nullptr;
+    std::string key = table + "." + column;
+    auto found = mappings.find(key);
+    if (found != mappings.end())
+        return &found->second;
+#if defined(_WIN32)
+    return nullptr;
+#else
+    int fd = ::open(columnPath(directory, table, column).c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+    struct stat info;
+    void* mapped = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(HistoryColumnHeader))
+        mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+        return nullptr;
+
+    const HistoryColumnHeader* header = static_cast<const HistoryColumnHeader*>(mapped);
+    size_t available = static_cast<size_t>(info.st_size) - sizeof(HistoryColumnHeader);
+    if (header->magic != HISTORY_MAGIC || header->version != HISTORY_VERSION ||
+        (header->valueSize != 4 && header->valueSize != 8) ||
+        header->rowCount > available / header->valueSize) {
+        munmap(mapped, info.st_size);
+        return nullptr;
+    }
+    Mapping& mapping = mappings[key];
+    mapping.region = mapped;
+    mapping.size = info.st_size;
+    mapping.view.data = static_cast<const char*>(mapped) + sizeof(HistoryColumnHeader);
+    mapping.view.count = static_cast<size_t>(header->rowCount);
+    mapping.view.valueSize = header->valueSize;
+    mapping.view.flags = header->flags;
+    return &mapping;
+#endif
+}
+
+bool HistoryReader::column(const std::string& table, const std::string& column, HistoryColumnView& view) {
+    const Mapping* mapping = map(table, column);
+    if (!mapping)
+        return false;
+    view = mapping->view;
+    return true;
+}
+
+bool HistoryReader::query(const std::string& table, const std::string& column, int firstDay, int lastDay,
+                          HistoryColumnView& view) {
+    HistoryColumnView days, values;
+    if (!this->column(table, "day", days) || !this->column(table, column, values))
+        return false;
+    // Both files may have been mapped at different moments of a live run; use the shorter.
+    size_t rows = std::min(days.count, values.count);
+    size_t lo = 0, hi = rows;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (days[mid] < firstDay) lo = mid + 1; else hi = mid;
+    }
+    size_t begin = lo;
+    hi = rows;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (days[mid] <= lastDay) lo = mid + 1; else hi = mid;
+    }
+    view = values;
+    view.data = values.data + begin * values.valueSize;
+    view.count = lo - begin;
+    return true;
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Initialization.h"
+
+// Per-day history of a run, kept on disk column by column so long runs can be analysed
+// afterwards without re-simulating. A store is a directory with four tables; rows are
+// appended in day order, so every table's "day" column is sorted:
+//   prices:     day, commodity, type, price                 (every resource and product)
+//   trades:     day, commodity, trades, volume, vwap, high, low (commodities traded that day)
+//   factories:  day, factory, balance, capacity, operatingCost  (player and AI factories)
+//   inventory:  day, factory, commodity, quantity
+// Each column is one file "<table>.<column>.col": a 64-byte header followed by the raw
+// values (int32 or int64, host byte order), written HISTORY_CHUNK_ROWS rows at a time.
+// The header's row count only covers complete writes, so readers never see torn rows.
+
+const uint32_t HISTORY_MAGIC = 0x5453484D; // "MHST"
+const uint32_t HISTORY_VERSION = 1;
+const uint32_t HISTORY_CHUNK_ROWS = 4096;
+
+// Column flags.
+const uint32_t HISTORY_COLUMN_PRICE = 1;    // Values are Price ticks.
+
+struct HistoryColumnHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t valueSize;                     // 4 or 8 bytes.
+    uint32_t flags;
+    uint64_t rowCount;
+    uint8_t reserved[40];
+};
+static_assert(sizeof(HistoryColumnHeader) == 64, "History column header is 64 bytes");
+
+class HistoryWriter {
+public:
+    HistoryWriter();
+    ~HistoryWriter();
+
+    HistoryWriter(const HistoryWriter&) = delete;
+    HistoryWriter& operator=(const HistoryWriter&) = delete;
+
+    // Creates 'directory' if needed and starts new column files (existing ones are replaced).
+    bool open(const std::string& directory);
+
+    // Writes buffered rows and closes the files.
+    void close();
+
+    bool isOpen() const { return !tables.empty(); }
+
+    // Appends one day: current prices, the aggregates of world.market.trades, and each
+    // factory's balance and inventory. Call after the price update, before the trades are
+    // cleared.
+    void recordDay(const SimulationWorld& world, int day);
+
+private:
+    struct ColumnSpec {
+        const char* name;
+        uint32_t valueSize;
+        uint32_t flags;
+    };
+    struct Column {
+        std::string name;
+        uint32_t valueSize;
+        uint32_t flags;
+        std::ofstream file;
+        std::vector<char> pending;
+    };
+    struct Table {
+        std::vector<Column> columns;
+        uint64_t rowCount = 0;              // Rows written to the files.
+        size_t pendingRows = 0;
+    };
+
+    Table& addTable(const std::string& name, const std::vector<ColumnSpec>& layout);
+    void appendRow(Table& table, const std::vector<int64_t>& values);
+    void flush(Table& table);
+
+    std::string directory;
+    std::map<std::string, std::unique_ptr<Table>> tables;
+    bool failed;
+};
+
+// Read-only view of consecutive values of one column. Points into the mapped file.
+struct HistoryColumnView {
+    const char* data = nullptr;
+    size_t count = 0;
+    uint32_t valueSize = 0;
+    uint32_t flags = 0;
+
+    int64_t operator[](size_t i) const;
+};
+
+// Maps column files read-only and answers day-range queries with binary search on the
+// table's day column. Mappings are kept until close. Not available on Windows (open returns false).
+class HistoryReader {
+public:
+    HistoryReader();
+    ~HistoryReader();
+
+    HistoryReader(const HistoryReader&) = delete;
+    HistoryReader& operator=(const HistoryReader&) = delete;
+
+    bool open(const std::string& directory);
+    void close();
+
+    // Every row of table.column. Returns false if the column does not exist or is invalid.
+    bool column(const std::string& table, const std::string& column, HistoryColumnView& view);
+
+    // The rows of table.column whose day is in firstDay .. lastDay (inclusive).
+    bool query(const std::string& table, const std::string& column, int firstDay, int lastDay,
+               HistoryColumnView& view);
+
+private:
+    struct Mapping {
+        void* region = nullptr;
+        size_t size = 0;
+        HistoryColumnView view;
+    };
+
+    const Mapping* map(const std::string& table, const std::string& column);
+
+    std::string directory;
+    std::map<std::string, Mapping> mappings;
+};
@@ -1,16 +1,15 @@
 #include "Initialization.h"
-#include <iostream>
+#include "Log.h"
 #include <random>
 #include <sstream>
 #include <algorithm>
 
-// You can adjust these constants as needed.
-const int NUM_RESOURCES = 20;
-const int NUM_PRODUCTS = 10;
-const int NUM_EQUIPMENTS = 5;
-const int NUM_AI_FACTORIES = 6;
-
 SimulationWorld initializeSimulation() {
+    std::random_device rd;
+    return initializeSimulation(rd());
+}
+
+SimulationWorld initializeSimulation(unsigned int seed) {
     SimulationWorld world;
 
     // --- Name Dictionaries ---
@@ -35,12 +34,11 @@ SimulationWorld initializeSimulation() {
     };
 
     // Random engine setup.
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    std::mt19937 gen(seed);
 
     // --- Generate Resource Catalog ---
     // Resources: commodity type Resource, no recipe.
-    std::uniform_real_distribution<float> resourcePriceDist(4.0f, 150.0f);
+    std::uniform_int_distribution<Price> resourcePriceDist(unitsToPrice(4), unitsToPrice(150));
     for (int i = 0; i < NUM_RESOURCES; i++) {
         Commodity res;
         res.id = i + 1; // IDs 1 .. NUM_RESOURCES.
@@ -64,9 +62,9 @@ SimulationWorld initializeSimulation() {
     }
 
     // --- Generate Equipment Catalog ---
-    std::uniform_real_distribution<float> equipPriceDist(10.0f, 50.0f);
+    std::uniform_int_distribution<Price> equipPriceDist(unitsToPrice(10), unitsToPrice(50));
     std::uniform_int_distribution<int> outputRateDist(1, 10);
-    std::uniform_real_distribution<float> operationalCostDist(10.0f, 50.0f);
+    std::uniform_int_distribution<Price> operationalCostDist(unitsToPrice(10), unitsToPrice(50));
     for (int i = 0; i < NUM_EQUIPMENTS; i++) {
         Equipment equip;
         equip.id = i + 1; // Equipment IDs: 1..NUM_EQUIPMENTS.
@@ -91,9 +89,11 @@ SimulationWorld initializeSimulation() {
     }
 
     // --- Generate Product Catalog ---
-    std::uniform_real_distribution<float> productPriceDist(75.0f, 700.0f);
+    std::uniform_int_distribution<Price> productPriceDist(unitsToPrice(75), unitsToPrice(700));
     std::uniform_int_distribution<int> recipeCountDist(1, 7);   // How many resource ingredients.
     std::uniform_int_distribution<int> recipeQtyDist(1, 10);      // Quantity required for each.
+    std::uniform_int_distribution<int> subProductCountDist(0, 2); // How many product ingredients.
+    std::uniform_int_distribution<int> subProductQtyDist(1, 3);
     for (int i = 0; i < NUM_PRODUCTS; i++) {
         Commodity prod;
         prod.id = NUM_RESOURCES + i + 1; // Product IDs start after resources.
@@ -126,6 +126,20 @@ SimulationWorld initializeSimulation() {
             }
         }
 
+        // Products may also be made from previously generated products. Only earlier
+        // products are eligible, which keeps the recipe graph acyclic.
+        if (!world.productCatalog.empty()) {
+            int numSubProducts = subProductCountDist(gen);
+            std::uniform_int_distribution<int> productIndexDist(0, world.productCatalog.size() - 1);
+            for (int j = 0; j < numSubProducts; j++) {
+                int subProductId = world.productCatalog[productIndexDist(gen)].id;
+                if (std::find(used.begin(), used.end(), subProductId) == used.end()) {
+                    prod.recipe.push_back({ subProductId, subProductQtyDist(gen) });
+                    used.push_back(subProductId);
+                }
+            }
+        }
+
         // Generate random equipment requirements.
         std::uniform_int_distribution<int> equipCountDist(1, NUM_EQUIPMENTS);
         int numEquipReq = equipCountDist(gen);
@@ -144,12 +158,16 @@ SimulationWorld initializeSimulation() {
         world.productCatalog.push_back(prod);
     }
 
+    // Order the recipes and prime the cost rollup.
+    world.productionGraph.build(world.resourceCatalog, world.productCatalog, world.equipmentCatalog);
+    world.production.build(world.resourceCatalog, world.productCatalog);
+
     // --- Initialize Player Factory ---
     world.playerFactory.id = 1;
-    world.playerFactory.balance = 1000.0f;
+    world.playerFactory.balance = unitsToPrice(1000);
     // Give player a fixed starting amount of each resource.
     for (const auto& res : world.resourceCatalog) {
-        world.playerFactory.inventory.push_back({ res, 10 });
+        world.playerFactory.inventory.write().push_back({ res, 10 });
     }
 
     // --- Generate AI Factories ---
@@ -157,16 +175,19 @@ SimulationWorld initializeSimulation() {
     for (int i = 0; i < NUM_AI_FACTORIES; i++) {
         Factory aiFactory;
         aiFactory.id = 2 + i;  // IDs: 2, 3, ...
-        aiFactory.balance = 1000.0f;
+        aiFactory.balance = unitsToPrice(1000);
         // Give each AI factory a random amount of each resource.
         for (const auto& res : world.resourceCatalog) {
             int qty = inventoryDist(gen);
-            aiFactory.inventory.push_back({ res, qty });
+            aiFactory.inventory.write().push_back({ res, qty });
         }
         world.aiFactories.push_back(aiFactory);
     }
 
-    std::cout << "Simulation initialized with:\n"
+    // The running world continues from its own stream, derived from the same seed.
+    world.rng.seed(gen());
+
+    simLog() << "Simulation initialized with:\n"
         << NUM_RESOURCES << " resources,\n"
         << NUM_PRODUCTS << " products,\n"
         << NUM_EQUIPMENTS << " equipment types,\n"
@@ -174,3 +195,35 @@ SimulationWorld initializeSimulation() {
 
     return world;
 }
+
+SimulationWorld forkWorld(const SimulationWorld& world) {
+    SimulationWorld fork = world;
+    fork.market.feed = nullptr;
+    fork.market.agentEvents = nullptr;
+    fork.market.deferred = nullptr;
+    return fork;
+}
+
+int maxCommodityId(const SimulationWorld& world) {
+    int maxId = 0;
+    for (const auto& res : world.resourceCatalog)
+        maxId = std::max(maxId, res.id);
+    for (const auto& prod : world.productCatalog)
+        maxId = std::max(maxId, prod.id);
+    return maxId;
+}
+
+Price commodityPrice(const SimulationWorld& world, int commodityId) {
+    int slot = world.priceEngine.slot(commodityId);
+    if (slot >= 0)
+        return world.priceEngine.price(slot);
+    for (const auto& res : world.resourceCatalog) {
+        if (res.id == commodityId)
+            return res.price;
+    }
+    for (const auto& prod : world.productCatalog) {
+        if (prod.id == commodityId)
+            return prod.price;
+    }
+    return 0;
+}
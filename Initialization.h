@@ -1,8 +1,19 @@
 #pragma once
 #include <vector>
+#include <random>
 #include "Market.h"
 #include "Factory.h"
 #include "Commodity.h"
+#include "ProductionGraph.h"
+#include "PriceEngine.h"
+#include "ProductionEngine.h"
+
+// Catalog sizes of generated worlds. You can adjust these constants as needed; they are
+// compile-time so fixed-size code (FixedWorld.h) can be specialised on them.
+constexpr int NUM_RESOURCES = 20;
+constexpr int NUM_PRODUCTS = 10;
+constexpr int NUM_EQUIPMENTS = 5;
+constexpr int NUM_AI_FACTORIES = 6;
 
 // Updated SimulationWorld with catalogs for resources, products, and equipment.
 struct SimulationWorld {
@@ -12,6 +23,29 @@ struct SimulationWorld {
     std::vector<Commodity> productCatalog;   // Manufacturable products.
     std::vector<Commodity> resourceCatalog;  // Raw resources.
     std::vector<Equipment> equipmentCatalog; // Equipment types.
+    ProductionGraph productionGraph;         // Recipe graph and cost rollup over the catalogs.
+    PriceEngine priceEngine;                 // Daily price dynamics of every commodity.
+    ProductionEngine production;             // Compiled recipes, shared by every controller.
+    std::mt19937 rng;                        // Randomness used while the world runs (e.g. daily supply).
 };
 
+// Generates a world from a non-deterministic seed.
 SimulationWorld initializeSimulation();
+
+// Generates a world deterministically from 'seed'; equal seeds give identical worlds.
+SimulationWorld initializeSimulation(unsigned int seed);
+
+// A copy of 'world' to try things on ("what if I place this order", "what if I buy this
+// equipment") and throw away. The order books and every factory's equipment and inventory
+// are shared with 'world' until either side changes them, so a fork costs about as much
+// as the catalogs, not the book or the factories. The fork is detached from the market
+// data feed, coroutine agents and deferred commands of 'world'. Forks and 'world' may
+// then run on different threads; only the fork itself must not overlap a change to 'world'.
+SimulationWorld forkWorld(const SimulationWorld& world);
+
+// Largest resource or product id in the catalogs, or 0 if they are empty.
+int maxCommodityId(const SimulationWorld& world);
+
+// Latest price of a commodity: the price engine's once it has run, else the catalog's.
+// 0 if the id is unknown.
+Price commodityPrice(const SimulationWorld& world, int commodityId);
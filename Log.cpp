@@ -0,0 +1,20 @@
+#include "Log.h"
+#include <iostream>
+
+namespace {
+    thread_local bool logEnabled = true;
+    // A stream without a buffer is permanently bad, so insertions return immediately.
+    thread_local std::ostream nullStream(nullptr);
+}
+
+std::ostream& simLog() {
+    return logEnabled ? std::cout : nullStream;
+}
+
+void setLogEnabled(bool enabled) {
+    logEnabled = enabled;
+}
+
+bool isLogEnabled() {
+    return logEnabled;
+}
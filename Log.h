@@ -0,0 +1,12 @@
+#pragma once
+#include <ostream>
+
+// Stream used by the simulation core for its running commentary (orders, trades, AI decisions).
+// It is std::cout by default. Turning it off for a thread makes every write a no-op, so
+// benchmarks and batch runs don't pay for console output.
+std::ostream& simLog();
+
+// Enables or disables simLog() output for the calling thread.
+void setLogEnabled(bool enabled);
+
+bool isLogEnabled();
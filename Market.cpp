@@ -1,61 +1,321 @@
 #include "Market.h"
-#include <iostream>
+#include "AgentCoroutines.h"
+#include "MarketDataFeed.h"
+#include "Log.h"
+#include "Metrics.h"
+#include "Trace.h"
 #include <algorithm>
 #include <limits>
+#include <unordered_map>
 
-Market::Market() : nextOrderId(1) {}
+Market::Market() : nextOrderId(1), feed(nullptr), agentEvents(nullptr), deferred(nullptr) {}
 
-void Market::placeBuyOrder(int productId, int amount, float maxPrice, int ownerId) {
+int Market::placeBuyOrder(int productId, int amount, Price maxPrice, int ownerId) {
+    METRICS_TIME(MetricPhase::OrderEntry);
+    METRICS_COUNT(MetricCounter::OrdersPlaced, 1);
+    if (deferred) {
+        deferred->push_back({ DeferredKind::Buy, nextOrderId, productId, amount, ownerId, 0, maxPrice });
+        return nextOrderId++;
+    }
     Order order = { nextOrderId++, productId, OrderType::BUY, maxPrice, amount, ownerId };
-    orders.push_back(order);
-    std::cout << "Placed BUY order: ID " << order.id
+    books[productId].write().push_back(order);
+    adjustResting(productId, OrderType::BUY, amount);
+    simLog() << "Placed BUY order: ID " << order.id
         << ", Product " << productId
         << ", Amount " << amount
-        << ", Max Price " << maxPrice << "\n";
+        << ", Max Price " << formatPrice(maxPrice) << "\n";
     matchOrders(productId);
+    return order.id;
 }
 
-void Market::placeSellOrder(int productId, int amount, float price, int ownerId) {
+int Market::placeSellOrder(int productId, int amount, Price price, int ownerId) {
+    METRICS_TIME(MetricPhase::OrderEntry);
+    METRICS_COUNT(MetricCounter::OrdersPlaced, 1);
+    if (deferred) {
+        deferred->push_back({ DeferredKind::Sell, nextOrderId, productId, amount, ownerId, 0, price });
+        return nextOrderId++;
+    }
     Order order = { nextOrderId++, productId, OrderType::SELL, price, amount, ownerId };
-    orders.push_back(order);
-    std::cout << "Placed SELL order: ID " << order.id
+    books[productId].write().push_back(order);
+    adjustResting(productId, OrderType::SELL, amount);
+    simLog() << "Placed SELL order: ID " << order.id
         << ", Product " << productId
         << ", Amount " << amount
-        << ", Price " << price << "\n";
+        << ", Price " << formatPrice(price) << "\n";
     // Only immediately match if the order is not a market-generated sell order.
     if (ownerId != 0) {
         matchOrders(productId);
     }
+    else {
+        publishBook(productId);
+    }
+    return order.id;
 }
 
+int Market::placeBasketOrder(std::vector<BasketLeg>& legs, BasketFill fill, int ownerId) {
+    METRICS_TIME(MetricPhase::OrderEntry);
+    METRICS_COUNT(MetricCounter::OrdersPlaced, 1);
+    TRACE_SCOPE_ARG("Market::placeBasketOrder", "legs", static_cast<int64_t>(legs.size()));
+    int basketId = nextOrderId++;
+    if (deferred) {
+        DeferredKind kind = fill == BasketFill::AllOrNone ? DeferredKind::BasketAllOrNone : DeferredKind::BasketProportional;
+        for (auto& leg : legs) {
+            leg.filled = 0;
+            deferred->push_back({ kind, basketId, leg.productId, leg.amount, ownerId, 0, leg.maxPrice });
+        }
+        return basketId;
+    }
+    simLog() << "Placed BASKET order: ID " << basketId
+        << ", Legs " << legs.size()
+        << ", " << (fill == BasketFill::AllOrNone ? "all-or-none" : "proportional") << "\n";
+
+    std::unordered_map<int, size_t> legOf;
+    for (auto& leg : legs)
+        leg.filled = 0;
+    for (size_t i = 0; i < legs.size(); i++) {
+        if (!legOf.emplace(legs[i].productId, i).second) {
+            simLog() << "Basket order ID " << basketId << " cancelled: Product "
+                << legs[i].productId << " appears in more than one leg\n";
+            return basketId;
+        }
+    }
+    // Size the basket by reading the legs' books, so a cancelled basket never unshares them.
+    auto takes = [](const Order& order, const BasketLeg& leg) {
+        return order.type == OrderType::SELL && order.amount > 0 && order.price <= leg.maxPrice;
+    };
+    std::vector<int64_t> available(legs.size(), 0);
+    for (size_t i = 0; i < legs.size(); i++) {
+        for (const auto& order : book(legs[i].productId)) {
+            if (takes(order, legs[i]))
+                available[i] += order.amount;
+        }
+    }
+
+    // The binding leg is the one the book covers least, relative to its amount; it sets
+    // the fraction every leg fills.
+    size_t binding = legs.size();
+    for (size_t i = 0; i < legs.size(); i++) {
+        if (legs[i].amount <= 0)
+            continue;
+        available[i] = std::min<int64_t>(available[i], legs[i].amount);
+        if (binding == legs.size() ||
+            available[i] * legs[binding].amount < available[binding] * legs[i].amount)
+            binding = i;
+    }
+    if (binding == legs.size())
+        return basketId;
+    int64_t covered = available[binding];
+    int64_t wanted = legs[binding].amount;
+    if (covered == 0 || (fill == BasketFill::AllOrNone && covered < wanted)) {
+        simLog() << "Basket order ID " << basketId << " cancelled: Product "
+            << legs[binding].productId << " has only " << covered << " of " << wanted << " available\n";
+        return basketId;
+    }
+
+    for (size_t i = 0; i < legs.size(); i++) {
+        if (legs[i].amount <= 0)
+            continue;
+        int target = static_cast<int>(legs[i].amount * covered / wanted);
+        if (target == 0)
+            continue;
+        int productId = legs[i].productId;
+        std::vector<Order>& legBook = books[productId].write();
+        std::vector<Order*> asks;
+        for (auto& order : legBook) {
+            if (takes(order, legs[i]))
+                asks.push_back(&order);
+        }
+        std::sort(asks.begin(), asks.end(), [](Order* a, Order* b) {
+            return a->price < b->price;
+            });
+        for (Order* ask : asks) {
+            if (legs[i].filled == target)
+                break;
+            int tradeAmount = std::min(target - legs[i].filled, ask->amount);
+            simLog() << "Trade executed: Product " << productId
+                << " | Amount: " << tradeAmount
+                << " | Price: " << formatPrice(ask->price) << "\n";
+            trades.push_back({ productId, basketId, ask->id, ownerId, ask->ownerId, tradeAmount, ask->price });
+            METRICS_COUNT(MetricCounter::Fills, 1);
+            if (feed)
+                feed->recordTrade(trades.back());
+            if (agentEvents)
+                agentEvents->onTrade(trades.back());
+            ask->amount -= tradeAmount;
+            legs[i].filled += tradeAmount;
+        }
+        adjustResting(productId, OrderType::SELL, -legs[i].filled);
+        legBook.erase(
+            std::remove_if(legBook.begin(), legBook.end(), [](const Order& o) {
+                return o.amount <= 0;
+                }),
+            legBook.end()
+        );
+    }
+
+    for (const auto& leg : legs) {
+        if (leg.filled > 0)
+            publishBook(leg.productId);
+    }
+    return basketId;
+}
 
 bool Market::removeOrder(int orderId, int ownerId) {
-    auto it = std::find_if(orders.begin(), orders.end(), [&](const Order& o) {
-        return o.id == orderId;
-        });
-    if (it != orders.end()) {
-        if (it->ownerId == ownerId) {
-            std::cout << "Removed order ID " << orderId << "\n";
-            orders.erase(it);
+    if (deferred) {
+        deferred->push_back({ DeferredKind::Cancel, orderId, 0, 0, ownerId, 0, 0 });
+        return true;
+    }
+    size_t index = 0;
+    CowVector<Order>* found = findOrder(orderId, index);
+    if (found) {
+        const Order& order = (*found)[index];
+        if (order.ownerId == ownerId) {
+            simLog() << "Removed order ID " << orderId << "\n";
+            int productId = order.productId;
+            adjustResting(productId, order.type, -order.amount);
+            // The order was looked up before unsharing the book, so misses never copy it.
+            std::vector<Order>& orders = found->write();
+            orders.erase(orders.begin() + index);
+            METRICS_COUNT(MetricCounter::Cancels, 1);
+            publishBook(productId);
             return true;
         }
         else {
-            std::cout << "Order ID " << orderId
+            simLog() << "Order ID " << orderId
                 << " does not belong to owner " << ownerId << "\n";
             return false;
         }
     }
-    std::cout << "Order ID " << orderId << " not found\n";
+    simLog() << "Order ID " << orderId << " not found\n";
     return false;
 }
 
+bool Market::amendOrder(int orderId, int ownerId, int newAmount, Price newPrice) {
+    METRICS_TIME(MetricPhase::OrderEntry);
+    if (newAmount <= 0)
+        return false;
+    if (deferred) {
+        deferred->push_back({ DeferredKind::Amend, orderId, 0, newAmount, ownerId, 0, newPrice });
+        return true;
+    }
+    size_t index = 0;
+    CowVector<Order>* found = findOrder(orderId, index);
+    if (!found) {
+        simLog() << "Order ID " << orderId << " not found\n";
+        return false;
+    }
+    const Order& current = (*found)[index];
+    if (current.ownerId != ownerId) {
+        simLog() << "Order ID " << orderId
+            << " does not belong to owner " << ownerId << "\n";
+        return false;
+    }
+    adjustResting(current.productId, current.type, newAmount - current.amount);
+    Order& order = found->write()[index];
+    order.amount = newAmount;
+    order.price = newPrice;
+    int productId = order.productId;
+    simLog() << "Amended order ID " << orderId
+        << ": Amount " << newAmount
+        << ", Price " << formatPrice(newPrice) << "\n";
+    // As with placement, market-generated sell orders wait for the next matching pass.
+    if (ownerId != 0)
+        matchOrders(productId);
+    else
+        publishBook(productId);
+    return true;
+}
+
+std::vector<Trade> Market::takeTrades() {
+    std::vector<Trade> executed;
+    executed.swap(trades);
+    return executed;
+}
+
+int64_t Market::restingAmount(int productId, OrderType type) const {
+    auto it = resting.find(productId);
+    if (it == resting.end())
+        return 0;
+    return type == OrderType::BUY ? it->second.buy : it->second.sell;
+}
+
+void Market::recountRestingAmounts() {
+    resting.clear();
+    for (const auto& entry : books) {
+        for (const auto& order : entry.second) {
+            if (order.amount > 0)
+                adjustResting(order.productId, order.type, order.amount);
+        }
+    }
+}
+
+const std::vector<Order>& Market::book(int productId) const {
+    static const std::vector<Order> none;
+    auto it = books.find(productId);
+    return it == books.end() ? none : it->second.read();
+}
+
+size_t Market::orderCount() const {
+    size_t count = 0;
+    for (const auto& entry : books)
+        count += entry.second.size();
+    return count;
+}
+
+void Market::collectOrders(std::vector<Order>& out) const {
+    out.clear();
+    out.reserve(orderCount());
+    for (const auto& entry : books)
+        out.insert(out.end(), entry.second.begin(), entry.second.end());
+}
+
+CowVector<Order>* Market::findOrder(int orderId, size_t& index) {
+    for (auto& entry : books) {
+        const std::vector<Order>& orders = entry.second.read();
+        auto it = std::find_if(orders.begin(), orders.end(), [&](const Order& o) {
+            return o.id == orderId;
+            });
+        if (it != orders.end()) {
+            index = it - orders.begin();
+            return &entry.second;
+        }
+    }
+    return nullptr;
+}
+
+void Market::adjustResting(int productId, OrderType type, int64_t delta) {
+    RestingAmounts& totals = resting[productId];
+    (type == OrderType::BUY ? totals.buy : totals.sell) += delta;
+}
+
 void Market::matchOrders(int productId) {
+    METRICS_TIME(MetricPhase::Matching);
+    TRACE_SCOPE_ARG("Market::matchOrders", "product", productId);
+    // Most calls cross nothing. Find that out from the book as it is, so those calls never
+    // unshare it; only a book with a trade to make (or spent orders to drop) is written.
+    Price bestBid = std::numeric_limits<Price>::min();
+    Price bestAsk = std::numeric_limits<Price>::max();
+    bool spent = false;
+    for (const auto& order : book(productId)) {
+        if (order.amount <= 0)
+            spent = true;
+        else if (order.type == OrderType::BUY)
+            bestBid = std::max(bestBid, order.price);
+        else
+            bestAsk = std::min(bestAsk, order.price);
+    }
+    if (bestBid < bestAsk && !spent) {
+        publishBook(productId);
+        return;
+    }
+
     // Create temporary vectors to hold pointers to BUY and SELL orders for the product.
     std::vector<Order*> buyOrders;
     std::vector<Order*> sellOrders;
 
+    std::vector<Order>& orders = books[productId].write();
     for (auto& order : orders) {
-        if (order.productId != productId || order.amount <= 0)
+        if (order.amount <= 0)
             continue;
         if (order.type == OrderType::BUY)
             buyOrders.push_back(&order);
@@ -82,14 +342,23 @@ void Market::matchOrders(int productId) {
         if (bestBuy->price >= bestSell->price) {
             // Execute a trade for the minimum amount between the two orders.
             int tradeAmount = std::min(bestBuy->amount, bestSell->amount);
-            float tradePrice = bestSell->price; // Using the SELL price as the trade price.
+            Price tradePrice = bestSell->price; // Using the SELL price as the trade price.
 
-            std::cout << "Trade executed: Product " << productId
+            simLog() << "Trade executed: Product " << productId
                 << " | Amount: " << tradeAmount
-                << " | Price: " << tradePrice << "\n";
+                << " | Price: " << formatPrice(tradePrice) << "\n";
+            trades.push_back({ productId, bestBuy->id, bestSell->id,
+                bestBuy->ownerId, bestSell->ownerId, tradeAmount, tradePrice });
+            METRICS_COUNT(MetricCounter::Fills, 1);
+            if (feed)
+                feed->recordTrade(trades.back());
+            if (agentEvents)
+                agentEvents->onTrade(trades.back());
 
             bestBuy->amount -= tradeAmount;
             bestSell->amount -= tradeAmount;
+            adjustResting(productId, OrderType::BUY, -tradeAmount);
+            adjustResting(productId, OrderType::SELL, -tradeAmount);
 
             // Remove orders from temporary lists if fully executed.
             if (bestBuy->amount == 0)
@@ -103,7 +372,11 @@ void Market::matchOrders(int productId) {
         }
     }
 
-    // Clean up the main order book by removing fully executed orders.
+    // Publish before the cleanup below invalidates the order pointers.
+    if (feed)
+        feed->publishBook(productId, buyOrders, sellOrders);
+
+    // Clean up the product's book by removing fully executed orders.
     orders.erase(
         std::remove_if(orders.begin(), orders.end(), [](const Order& o) {
             return o.amount <= 0;
@@ -111,3 +384,26 @@ void Market::matchOrders(int productId) {
         orders.end()
     );
 }
+
+void Market::publishBook(int productId) {
+    if (!feed || !feed->isOpen())
+        return;
+    // Reads only, so publishing never unshares the book of a forked world.
+    std::vector<const Order*> buyOrders;
+    std::vector<const Order*> sellOrders;
+    for (const auto& order : book(productId)) {
+        if (order.amount <= 0)
+            continue;
+        if (order.type == OrderType::BUY)
+            buyOrders.push_back(&order);
+        else
+            sellOrders.push_back(&order);
+    }
+    std::sort(buyOrders.begin(), buyOrders.end(), [](const Order* a, const Order* b) {
+        return a->price > b->price;
+        });
+    std::sort(sellOrders.begin(), sellOrders.end(), [](const Order* a, const Order* b) {
+        return a->price < b->price;
+        });
+    feed->publishBook(productId, buyOrders, sellOrders);
+}
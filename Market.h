@@ -1,5 +1,10 @@
 #pragma once
+#include <cstdint>
+#include <map>
+#include <unordered_map>
 #include <vector>
+#include "Price.h"
+#include "CopyOnWrite.h"
 
 enum class OrderType { BUY, SELL };
 
@@ -7,30 +12,133 @@ struct Order {
     int id;         // Unique order identifier
     int productId;  // The product for which the order is placed
     OrderType type;
-    float price;    // For BUY orders, this is the maximum price; for SELL orders, its the asking price.
+    Price price;    // For BUY orders, this is the maximum price; for SELL orders, its the asking price.
     int amount;     // Quantity of the product
     int ownerId;    // Identifier for the factory or market participant
 };
 
+// A single execution produced by the matching engine.
+struct Trade {
+    int productId;
+    int buyOrderId;
+    int sellOrderId;
+    int buyerId;    // ownerId of the BUY order
+    int sellerId;   // ownerId of the SELL order
+    int amount;
+    Price price;    // Execution price (the SELL order's price).
+};
+
+// One leg of a basket order: buy up to 'amount' of a product at no more than 'maxPrice'.
+// 'filled' is set by Market::placeBasketOrder.
+struct BasketLeg {
+    int productId;
+    int amount;
+    Price maxPrice;
+    int filled;
+};
+
+enum class BasketFill {
+    AllOrNone,      // Every leg fills completely, or nothing trades.
+    Proportional,   // Every leg fills the same fraction of its amount, as large as the book allows.
+};
+
+// An order operation recorded by a deferring Market instead of being applied (see
+// Market::deferred). Fixed-size, so batches can be shipped between processes as is.
+enum class DeferredKind : int32_t { Buy, Sell, Cancel, Amend, BasketAllOrNone, BasketProportional };
+
+struct DeferredCommand {
+    DeferredKind kind;
+    int32_t orderId;    // Id handed out for Buy, Sell and baskets; the target of Cancel and Amend.
+    int32_t productId;  // Unused for Cancel and Amend.
+    int32_t amount;
+    int32_t ownerId;
+    int32_t reserved;
+    Price price;
+};
+
+class MarketDataFeed;
+class AgentScheduler;
+
 class Market {
 public:
-    // Order book for all products.
-    std::vector<Order> orders;
+    // Order books by product id, each in time priority. Copies of a Market share every book
+    // until one of them changes it, so a copy only pays for the books it trades in. Change
+    // one directly through books[productId].write(), then call recountRestingAmounts().
+    std::map<int, CowVector<Order>> books;
     int nextOrderId;
+    // Trades executed since the last call to takeTrades(), in execution order.
+    std::vector<Trade> trades;
+    // Optional shared-memory market data; when set, every book change is published to it.
+    MarketDataFeed* feed;
+    // Optional coroutine agent scheduler; when set, it is told about every trade so it can
+    // queue the agents waiting on those orders (see AgentCoroutines.h).
+    AgentScheduler* agentEvents;
+    // Optional command buffer. When set, order operations are appended to it instead of
+    // touching the book: places and baskets still get ids from nextOrderId but never fill,
+    // and cancels and amends report success. A basket is one command per leg, all with
+    // the basket's id.
+    std::vector<DeferredCommand>* deferred;
 
     Market();
 
-    // Place a BUY order (bid) for a product.
-    void placeBuyOrder(int productId, int amount, float maxPrice, int ownerId);
+    // Place a BUY order (bid) for a product. Returns the new order's id.
+    int placeBuyOrder(int productId, int amount, Price maxPrice, int ownerId);
+
+    // Place a SELL order (ask) for a product. Returns the new order's id.
+    int placeSellOrder(int productId, int amount, Price price, int ownerId);
 
-    // Place a SELL order (ask) for a product.
-    void placeSellOrder(int productId, int amount, float price, int ownerId);
+    // Buy several products at once (at most one leg per product; a basket naming a product
+    // twice is cancelled without trading). The basket executes against resting SELL orders
+    // straight away and never rests: whatever cannot be filled under 'fill' is cancelled.
+    // Each leg's 'filled' is set; the trades carry the basket's id as their buyOrderId.
+    // Returns that id.
+    int placeBasketOrder(std::vector<BasketLeg>& legs, BasketFill fill, int ownerId);
 
     // Remove an existing order (only if the owner requests it).
     // Returns true if the order is found and removed; false otherwise.
     bool removeOrder(int orderId, int ownerId);
 
+    // Change the quantity and price of an existing order (only if the owner requests it).
+    // The order keeps its id and is matched again at the new price.
+    // Returns true if the order is found and amended; false otherwise.
+    bool amendOrder(int orderId, int ownerId, int newAmount, Price newPrice);
+
+    // Hands over the trades executed since the previous call and clears the buffer.
+    std::vector<Trade> takeTrades();
+
+    // Total resting quantity of a product on one side of the book. Kept up to date by the
+    // member functions above, so it costs a lookup rather than a scan of the book.
+    int64_t restingAmount(int productId, OrderType type) const;
+
+    // Recomputes the resting totals after 'books' was changed directly.
+    void recountRestingAmounts();
+
+    // Resting orders of one product, in time priority (empty if it has none).
+    const std::vector<Order>& book(int productId) const;
+
+    // Number of resting orders over all products.
+    size_t orderCount() const;
+
+    // Copies every resting order into 'out', product by product, for callers that need them
+    // in one array (the C API's order view).
+    void collectOrders(std::vector<Order>& out) const;
+
 private:
+    struct RestingAmounts {
+        int64_t buy = 0;
+        int64_t sell = 0;
+    };
+
+    void adjustResting(int productId, OrderType type, int64_t delta);
+
+    // The book holding order 'orderId', with the order's position in it; nullptr if none.
+    CowVector<Order>* findOrder(int orderId, size_t& index);
+
     // Matching engine for a given product. It matches BUY orders with SELL orders.
     void matchOrders(int productId);
+
+    // Publishes a product's book to the feed after a change that did not run matchOrders.
+    void publishBook(int productId);
+
+    std::unordered_map<int, RestingAmounts> resting;
 };
@@ -0,0 +1,272 @@
+#include "MarketDataFeed.h"
+#include "Log.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    int64_t steadyNowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Slots start on a cache line after the header.
+    size_t slotsOffset() {
+        return (sizeof(MarketDataHeader) + 63) / 64 * 64;
+    }
+
+    // Aggregates orders (best first) into price levels.
+    template <typename OrderPointer>
+    void fillLevels(const std::vector<OrderPointer>& orders, Price* prices, int32_t* amounts,
+                    int32_t& orderCount, int32_t& totalAmount) {
+        int level = -1;
+        orderCount = 0;
+        totalAmount = 0;
+        for (int i = 0; i < MARKET_DATA_DEPTH; i++) {
+            prices[i] = 0;
+            amounts[i] = 0;
+        }
+        for (const Order* order : orders) {
+            if (order->amount <= 0)
+                continue;   // Filled during this matching pass.
+            orderCount++;
+            totalAmount += order->amount;
+            if (level < 0 || order->price != prices[level]) {
+                if (level + 1 >= MARKET_DATA_DEPTH)
+                    continue;
+                level++;
+                prices[level] = order->price;
+            }
+            amounts[level] += order->amount;
+        }
+    }
+}
+
+MarketDataFeed::MarketDataFeed() : region(nullptr), regionSize(0), slots(nullptr), slotCount(0) {}
+
+MarketDataFeed::~MarketDataFeed() {
+    close();
+}
+
+bool MarketDataFeed::create(const std::string& feedName, int requestedSlots) {
+    close();
+    reportedOutOfRange = false;
+#if defined(_WIN32)
+    simLog() << "MarketDataFeed: shared-memory feeds are not supported on Windows\n";
+    return false;
+#else
+    if (requestedSlots <= 0)
+        return false;
+    size_t size = slotsOffset() + requestedSlots * sizeof(MarketDataSlot);
+    shm_unlink(feedName.c_str());
+    int fd = shm_open(feedName.c_str(), O_CREAT | O_RDWR | O_EXCL, 0644);
+    if (fd < 0) {
+        simLog() << "MarketDataFeed: cannot create " << feedName << "\n";
+        return false;
+    }
+    void* mapped = MAP_FAILED;
+    if (ftruncate(fd, size) == 0)
+        mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        shm_unlink(feedName.c_str());
+        simLog() << "MarketDataFeed: cannot map " << feedName << "\n";
+        return false;
+    }
+
+    // The object is new, so it is zero-filled: every sequence starts at 0 ("never published").
+    name = feedName;
+    region = mapped;
+    regionSize = size;
+    slotCount = requestedSlots;
+    slots = reinterpret_cast<MarketDataSlot*>(static_cast<char*>(mapped) + slotsOffset());
+    MarketDataHeader* header = static_cast<MarketDataHeader*>(mapped);
+    header->slotCount = requestedSlots;
+    header->slotSize = sizeof(MarketDataSlot);
+    header->version = MARKET_DATA_VERSION;
+    // Readers check the magic last, so they never see a half-initialised header.
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = MARKET_DATA_MAGIC;
+    return true;
+#endif
+}
+
+void MarketDataFeed::close() {
+#if !defined(_WIN32)
+    if (region) {
+        munmap(region, regionSize);
+        shm_unlink(name.c_str());
+    }
+#endif
+    region = nullptr;
+    regionSize = 0;
+    slots = nullptr;
+    slotCount = 0;
+    pendingTrades.clear();
+}
+
+MarketDataSlot* MarketDataFeed::slotFor(int commodityId) {
+    if (!slots)
+        return nullptr;
+    if (commodityId < 0 || commodityId >= slotCount) {
+        if (!reportedOutOfRange) {
+            reportedOutOfRange = true;
+            simLog() << "MarketDataFeed: commodity id " << commodityId << " has no slot (the feed has "
+                << slotCount << "); such commodities are not published\n";
+        }
+        return nullptr;
+    }
+    return &slots[commodityId];
+}
+
+void MarketDataFeed::beginWrite(MarketDataSlot& slot) {
+    uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.quote.commodityId = static_cast<int32_t>(&slot - slots);
+}
+
+void MarketDataFeed::endWrite(MarketDataSlot& slot) {
+    slot.quote.publishNs = steadyNowNs();
+    slot.sequence.store(slot.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void MarketDataFeed::publishBook(int commodityId, const std::vector<Order*>& bids, const std::vector<Order*>& asks) {
+    publishLevels(commodityId, bids, asks);
+}
+
+void MarketDataFeed::publishBook(int commodityId, const std::vector<const Order*>& bids,
+                                 const std::vector<const Order*>& asks) {
+    publishLevels(commodityId, bids, asks);
+}
+
+template <typename OrderPointer>
+void MarketDataFeed::publishLevels(int commodityId, const std::vector<OrderPointer>& bids,
+                                   const std::vector<OrderPointer>& asks) {
+    // Only this commodity's trades are consumed; a basket publishes each leg in turn.
+    auto dropTrades = [&] {
+        pendingTrades.erase(
+            std::remove_if(pendingTrades.begin(), pendingTrades.end(), [&](const Trade& trade) {
+                return trade.productId == commodityId;
+                }),
+            pendingTrades.end());
+    };
+    MarketDataSlot* slot = slotFor(commodityId);
+    if (!slot) {
+        dropTrades();
+        return;
+    }
+    beginWrite(*slot);
+    MarketQuote& quote = slot->quote;
+    fillLevels(bids, quote.bidPrice, quote.bidLevelAmount, quote.bidOrders, quote.bidAmount);
+    fillLevels(asks, quote.askPrice, quote.askLevelAmount, quote.askOrders, quote.askAmount);
+    for (const Trade& trade : pendingTrades) {
+        if (trade.productId != commodityId)
+            continue;
+        quote.lastTradePrice = trade.price;
+        quote.lastTradeAmount = trade.amount;
+        quote.tradeCount++;
+    }
+    endWrite(*slot);
+    dropTrades();
+}
+
+void MarketDataFeed::recordTrade(const Trade& trade) {
+    if (slots)
+        pendingTrades.push_back(trade);
+}
+
+void MarketDataFeed::publishReferencePrice(int commodityId, Price price) {
+    MarketDataSlot* slot = slotFor(commodityId);
+    if (!slot)
+        return;
+    beginWrite(*slot);
+    slot->quote.referencePrice = price;
+    endWrite(*slot);
+}
+
+MarketDataReader::MarketDataReader() : region(nullptr), regionSize(0), slots(nullptr), count(0) {}
+
+MarketDataReader::~MarketDataReader() {
+    close();
+}
+
+bool MarketDataReader::open(const std::string& feedName) {
+    close();
+#if defined(_WIN32)
+    return false;
+#else
+    int fd = shm_open(feedName.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    void* mapped = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= slotsOffset())
+        mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+        return false;
+
+    const MarketDataHeader* header = static_cast<const MarketDataHeader*>(mapped);
+    bool compatible = header->magic == MARKET_DATA_MAGIC;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    compatible = compatible && header->version == MARKET_DATA_VERSION &&
+        header->slotSize == sizeof(MarketDataSlot) &&
+        slotsOffset() + static_cast<size_t>(header->slotCount) * sizeof(MarketDataSlot) <= static_cast<size_t>(info.st_size);
+    if (!compatible) {
+        munmap(mapped, info.st_size);
+        return false;
+    }
+    region = mapped;
+    regionSize = info.st_size;
+    slots = reinterpret_cast<const MarketDataSlot*>(static_cast<const char*>(mapped) + slotsOffset());
+    count = static_cast<int>(header->slotCount);
+    return true;
+#endif
+}
+
+void MarketDataReader::close() {
+#if !defined(_WIN32)
+    if (region)
+        munmap(const_cast<void*>(region), regionSize);
+#endif
+    region = nullptr;
+    regionSize = 0;
+    slots = nullptr;
+    count = 0;
+}
+
+uint32_t MarketDataReader::sequence(int commodityId) const {
+    if (!slots || commodityId < 0 || commodityId >= count)
+        return 0;
+    return slots[commodityId].sequence.load(std::memory_order_acquire);
+}
+
+bool MarketDataReader::read(int commodityId, MarketQuote& quote, uint64_t* retries) const {
+    if (!slots || commodityId < 0 || commodityId >= count)
+        return false;
+    const MarketDataSlot& slot = slots[commodityId];
+    while (true) {
+        uint32_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before == 0)
+            return false;
+        if (before & 1) {
+            if (retries)
+                (*retries)++;
+            continue;   // Writer in progress.
+        }
+        std::memcpy(&quote, &slot.quote, sizeof(quote));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == before)
+            return true;
+        if (retries)
+            (*retries)++;
+    }
+}
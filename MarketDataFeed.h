@@ -0,0 +1,125 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Market.h"
+
+// Market data published to a POSIX shared-memory region, so other processes can watch
+// the book without sockets or locks. Each commodity has a fixed slot (slot index =
+// commodity id) guarded by a seqlock: the single writer makes the slot's sequence odd,
+// updates the quote and makes it even again; readers copy the quote and retry if the
+// sequence was odd or changed meanwhile. Readers never block the writer.
+// Not available on Windows (create/open return false).
+
+const int MARKET_DATA_DEPTH = 5;          // Price levels published per side.
+const uint32_t MARKET_DATA_MAGIC = 0x4D534644; // "MSFD"
+const uint32_t MARKET_DATA_VERSION = 2;
+
+// One commodity's snapshot. Prices are in ticks (Price.h). Levels are best first; unused
+// levels have amount 0.
+struct MarketQuote {
+    int32_t commodityId;
+    int32_t bidOrders;                    // Resting BUY orders.
+    int32_t askOrders;                    // Resting SELL orders.
+    int32_t bidAmount;                    // Total resting BUY quantity.
+    int32_t askAmount;                    // Total resting SELL quantity.
+    int32_t lastTradeAmount;
+    Price bidPrice[MARKET_DATA_DEPTH];
+    Price askPrice[MARKET_DATA_DEPTH];
+    int32_t bidLevelAmount[MARKET_DATA_DEPTH];
+    int32_t askLevelAmount[MARKET_DATA_DEPTH];
+    Price lastTradePrice;
+    Price referencePrice;                 // Price set by the daily price update.
+    uint64_t tradeCount;                  // Trades since the feed was created.
+    int64_t publishNs;                    // steady_clock time of the last update (for latency checks).
+};
+
+struct MarketDataSlot {
+    alignas(64) std::atomic<uint32_t> sequence;  // Odd while the writer is updating the quote.
+    MarketQuote quote;
+};
+
+struct MarketDataHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t slotSize;
+};
+
+// Writer side. The Market and the PriceEngine publish through this when attached
+// (Market::feed); all publishing must happen on one thread.
+class MarketDataFeed {
+public:
+    MarketDataFeed();
+    ~MarketDataFeed();
+
+    MarketDataFeed(const MarketDataFeed&) = delete;
+    MarketDataFeed& operator=(const MarketDataFeed&) = delete;
+
+    // Creates (or replaces) the shared-memory object 'name' (e.g. "/market_sim_feed") with
+    // slots for commodity ids 0 .. slotCount - 1; size it with maxCommodityId(world) + 1.
+    // Commodities outside the slots are not published (logged once). Returns false on error.
+    bool create(const std::string& name, int slotCount = 256);
+
+    // Unmaps and removes the shared-memory object.
+    void close();
+
+    bool isOpen() const { return slots != nullptr; }
+
+    // Publishes a commodity's book. 'bids' and 'asks' hold its resting orders best first.
+    void publishBook(int commodityId, const std::vector<Order*>& bids, const std::vector<Order*>& asks);
+    void publishBook(int commodityId, const std::vector<const Order*>& bids,
+                     const std::vector<const Order*>& asks);
+
+    // Remembers an execution; it is published with the next publishBook for its commodity.
+    void recordTrade(const Trade& trade);
+
+    void publishReferencePrice(int commodityId, Price price);
+
+private:
+    template <typename OrderPointer>
+    void publishLevels(int commodityId, const std::vector<OrderPointer>& bids,
+                       const std::vector<OrderPointer>& asks);
+    MarketDataSlot* slotFor(int commodityId);
+    void beginWrite(MarketDataSlot& slot);
+    void endWrite(MarketDataSlot& slot);
+
+    std::string name;
+    void* region;
+    size_t regionSize;
+    MarketDataSlot* slots;
+    int slotCount;
+    std::vector<Trade> pendingTrades;
+    bool reportedOutOfRange = false;
+};
+
+// Reader side, for tools and agents in other processes.
+class MarketDataReader {
+public:
+    MarketDataReader();
+    ~MarketDataReader();
+
+    MarketDataReader(const MarketDataReader&) = delete;
+    MarketDataReader& operator=(const MarketDataReader&) = delete;
+
+    // Maps an existing feed read-only. Returns false if it does not exist or is incompatible.
+    bool open(const std::string& name);
+    void close();
+
+    int slotCount() const { return count; }
+
+    // Current sequence of a slot: 0 = never published; it changes on every update.
+    uint32_t sequence(int commodityId) const;
+
+    // Copies a consistent snapshot of a commodity's quote. Returns false if the id is out
+    // of range or was never published. 'retries' (optional) is increased by the number of
+    // torn reads that had to be repeated.
+    bool read(int commodityId, MarketQuote& quote, uint64_t* retries = nullptr) const;
+
+private:
+    const void* region;
+    size_t regionSize;
+    const MarketDataSlot* slots;
+    int count;
+};
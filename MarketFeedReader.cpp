@@ -0,0 +1,106 @@
+// Watches the shared-memory market data published by a running simulation.
+//
+// Usage: market_feed_reader [--feed NAME] [--interval-ms N] [--count N] [--latency SECONDS]
+//
+// By default prints every published commodity's top of book and last trade every
+// --interval-ms (--count snapshots, 0 = until interrupted). --latency spins on the feed for
+// the given time and reports how long updates took to become visible (publish to read),
+// how many updates were seen and how many torn reads had to be retried.
+#include "MarketDataFeed.h"
+#include "Metrics.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    int64_t steadyNowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void printSnapshot(const MarketDataReader& reader) {
+        std::cout << std::setw(6) << "id" << std::setw(10) << "bid" << std::setw(8) << "size"
+            << std::setw(10) << "ask" << std::setw(8) << "size"
+            << std::setw(10) << "last" << std::setw(8) << "trades" << std::setw(10) << "ref" << "\n";
+        for (int id = 0; id < reader.slotCount(); id++) {
+            MarketQuote quote;
+            if (!reader.read(id, quote))
+                continue;
+            std::cout << std::setw(6) << id
+                << std::setw(10) << formatPrice(quote.bidPrice[0]) << std::setw(8) << quote.bidLevelAmount[0]
+                << std::setw(10) << formatPrice(quote.askPrice[0]) << std::setw(8) << quote.askLevelAmount[0]
+                << std::setw(10) << formatPrice(quote.lastTradePrice) << std::setw(8) << quote.tradeCount
+                << std::setw(10) << formatPrice(quote.referencePrice) << "\n";
+        }
+    }
+
+    void measureLatency(const MarketDataReader& reader, double seconds) {
+        std::vector<uint32_t> seen(reader.slotCount(), 0);
+        LatencyHistogram latency;
+        uint64_t retries = 0;
+        int64_t end = steadyNowNs() + static_cast<int64_t>(seconds * 1e9);
+        while (steadyNowNs() < end) {
+            for (int id = 0; id < reader.slotCount(); id++) {
+                uint32_t sequence = reader.sequence(id);
+                if (sequence == seen[id] || (sequence & 1))
+                    continue;
+                MarketQuote quote;
+                if (!reader.read(id, quote, &retries))
+                    continue;
+                int64_t delay = steadyNowNs() - quote.publishNs;
+                // The first sighting of a slot may be an old update; only count fresh ones.
+                if (seen[id] != 0)
+                    latency.record(delay > 0 ? static_cast<uint64_t>(delay) : 0);
+                seen[id] = sequence;
+            }
+        }
+        std::cout << "Updates seen: " << latency.count() << ", torn reads retried: " << retries << "\n";
+        if (latency.count()) {
+            std::cout << "Publish-to-read latency (ns): p50 " << latency.percentile(0.50)
+                << ", p90 " << latency.percentile(0.90)
+                << ", p99 " << latency.percentile(0.99)
+                << ", max " << latency.max() << "\n";
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string feedName = "/market_sim_feed";
+    int intervalMs = 1000;
+    int count = 0;
+    double latencySeconds = 0.0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--feed")
+            feedName = argv[i + 1];
+        else if (arg == "--interval-ms")
+            intervalMs = std::atoi(argv[i + 1]);
+        else if (arg == "--count")
+            count = std::atoi(argv[i + 1]);
+        else if (arg == "--latency")
+            latencySeconds = std::atof(argv[i + 1]);
+        else
+            std::cout << "Ignoring unknown option " << arg << "\n";
+    }
+
+    MarketDataReader reader;
+    if (!reader.open(feedName)) {
+        std::cout << "Cannot open market data feed " << feedName << "\n";
+        return 1;
+    }
+    if (latencySeconds > 0.0) {
+        measureLatency(reader, latencySeconds);
+        return 0;
+    }
+    for (int n = 0; count == 0 || n < count; n++) {
+        if (n > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+        std::cout << "\n";
+        printSnapshot(reader);
+    }
+    return 0;
+}
@@ -0,0 +1,64 @@
+// Prints one column of a history store written with `market_simulation --history DIR`.
+//
+// Usage: market_history DIR TABLE COLUMN [--from DAY] [--to DAY]
+//
+// Each output line is the row's day, its key (the table's second column: commodity,
+// product or factory id) and the requested value. Price columns are printed in currency
+// units. Tables and columns are listed in HistoryStore.h.
+#include "HistoryStore.h"
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+    const char* keyColumn(const std::string& table) {
+        if (table == "prices")
+            return "commodity";
+        if (table == "factories" || table == "inventory")
+            return "factory";
+        return "commodity";
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        std::cout << "Usage: market_history DIR TABLE COLUMN [--from DAY] [--to DAY]\n";
+        return 1;
+    }
+    std::string directory = argv[1];
+    std::string table = argv[2];
+    std::string column = argv[3];
+    int firstDay = 0;
+    int lastDay = INT_MAX;
+    for (int i = 4; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--from")
+            firstDay = std::atoi(argv[i + 1]);
+        else if (arg == "--to")
+            lastDay = std::atoi(argv[i + 1]);
+        else
+            std::cout << "Ignoring unknown option " << arg << "\n";
+    }
+
+    HistoryReader reader;
+    if (!reader.open(directory)) {
+        std::cout << "Cannot open history store " << directory << "\n";
+        return 1;
+    }
+    HistoryColumnView days, keys, values;
+    if (!reader.query(table, "day", firstDay, lastDay, days) ||
+        !reader.query(table, keyColumn(table), firstDay, lastDay, keys) ||
+        !reader.query(table, column, firstDay, lastDay, values)) {
+        std::cout << "No column " << table << "." << column << " in " << directory << "\n";
+        return 1;
+    }
+    for (size_t i = 0; i < values.count && i < keys.count && i < days.count; i++) {
+        std::cout << days[i] << " " << keys[i] << " ";
+        if (values.flags & HISTORY_COLUMN_PRICE)
+            std::cout << formatPrice(values[i]) << "\n";
+        else
+            std::cout << values[i] << "\n";
+    }
+    return 0;
+}
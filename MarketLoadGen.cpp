@@ -0,0 +1,201 @@
+// Drives a Market with synthetic order flow to see how it holds up under load.
+//
+// Usage: market_loadgen [--rate OPS_PER_SEC] [--seconds S] [--commodities N]
+//                       [--cancel-ratio R] [--size-alpha A] [--max-size N]
+//                       [--offset-ticks T] [--sample-ms N] [--seed S]
+//
+// Open loop: operations arrive as a Poisson stream at --rate regardless of how fast the
+// Market keeps up, so a slow book shows up as lag instead of as a lower offered load.
+// A fraction --cancel-ratio of operations cancel a random earlier order. The rest are new
+// orders for a random commodity with Pareto sizes (exponent --size-alpha, 1 to
+// --max-size), priced around that commodity's mid (its last trade price) with a normal
+// offset of --offset-ticks (0 prices every order at the mid). The tool prints the book
+// depth every --sample-ms, then the sustained throughput and per-operation latency
+// percentiles. Service time measures the Market call alone. Response time runs from the
+// scheduled arrival, so it includes any time spent queued behind the schedule.
+#include "Market.h"
+#include "Metrics.h"
+#include "Log.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    const int OWNER_ID = 1;
+    const Price INITIAL_MID = unitsToPrice(100);
+
+    struct LoadConfig {
+        double rate = 10000.0;
+        double seconds = 10.0;
+        int commodities = 100;
+        double cancelRatio = 0.3;
+        double sizeAlpha = 1.5;
+        int maxSize = 1000;
+        double offsetTicks = 50.0;
+        int sampleMs = 1000;
+        unsigned int seed = 1;
+    };
+
+    int64_t nanosSince(Clock::time_point start, Clock::time_point now) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+    }
+
+    void printLatency(const char* name, const LatencyHistogram& histogram) {
+        std::cout << std::left << std::setw(18) << name << std::right
+            << std::setw(12) << histogram.count();
+        if (histogram.count()) {
+            std::cout << std::setw(12) << histogram.percentile(0.50)
+                << std::setw(12) << histogram.percentile(0.99)
+                << std::setw(12) << histogram.percentile(0.999)
+                << std::setw(14) << histogram.max();
+        }
+        std::cout << "\n";
+    }
+
+    void run(const LoadConfig& config) {
+        setLogEnabled(false);
+        Market market;
+        std::mt19937_64 gen(config.seed);
+        std::exponential_distribution<double> gap(config.rate / 1e9);   // Per nanosecond.
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        std::uniform_int_distribution<int> pickCommodity(1, config.commodities);
+        std::normal_distribution<double> offset(0.0, config.offsetTicks > 0.0 ? config.offsetTicks : 1.0);
+        std::vector<Price> mid(config.commodities + 1, INITIAL_MID);
+        std::vector<int> live;   // Ids of placed orders, some of which have since filled.
+
+        LatencyHistogram placeService;
+        LatencyHistogram cancelService;
+        LatencyHistogram response;
+        uint64_t places = 0, cancels = 0, cancelMisses = 0, fills = 0;
+        int64_t maxLagNs = 0;
+
+        std::cout << std::setw(8) << "time_s" << std::setw(12) << "ops" << std::setw(12) << "orders"
+            << std::setw(14) << "bid_qty" << std::setw(14) << "ask_qty" << std::setw(12) << "lag_ms" << "\n";
+        const int64_t durationNs = static_cast<int64_t>(config.seconds * 1e9);
+        const int64_t sampleNs = static_cast<int64_t>(config.sampleMs) * 1000000;
+        int64_t nextSampleNs = sampleNs;
+        int64_t scheduledNs = 0;
+        Clock::time_point start = Clock::now();
+        while (true) {
+            scheduledNs += static_cast<int64_t>(gap(gen));
+            if (scheduledNs >= durationNs)
+                break;
+            int64_t nowNs = nanosSince(start, Clock::now());
+            if (scheduledNs - nowNs > 1000000)
+                std::this_thread::sleep_for(std::chrono::nanoseconds(scheduledNs - nowNs - 500000));
+            while ((nowNs = nanosSince(start, Clock::now())) < scheduledNs)
+                ;   // Spin for the last stretch; sleeping is too coarse.
+            maxLagNs = std::max(maxLagNs, nowNs - scheduledNs);
+
+            bool cancel = !live.empty() && unit(gen) < config.cancelRatio;
+            Clock::time_point opStart;
+            if (cancel) {
+                size_t pick = std::uniform_int_distribution<size_t>(0, live.size() - 1)(gen);
+                int orderId = live[pick];
+                live[pick] = live.back();
+                live.pop_back();
+                opStart = Clock::now();
+                if (!market.removeOrder(orderId, OWNER_ID))
+                    cancelMisses++;
+                cancelService.record(static_cast<uint64_t>(nanosSince(opStart, Clock::now())));
+                cancels++;
+            }
+            else {
+                int commodity = pickCommodity(gen);
+                bool buy = unit(gen) < 0.5;
+                // Pareto: P(size > s) = s^-alpha.
+                double pareto = std::pow(1.0 - unit(gen), -1.0 / config.sizeAlpha);
+                int amount = static_cast<int>(std::min(pareto, static_cast<double>(config.maxSize)));
+                // A zero spread has no distribution to draw from (its sigma must be > 0).
+                Price shift = config.offsetTicks > 0.0 ? static_cast<Price>(std::llround(offset(gen))) : 0;
+                Price price = std::max<Price>(buy ? mid[commodity] - shift : mid[commodity] + shift, 1);
+                opStart = Clock::now();
+                int orderId = buy
+                    ? market.placeBuyOrder(commodity, amount, price, OWNER_ID)
+                    : market.placeSellOrder(commodity, amount, price, OWNER_ID);
+                placeService.record(static_cast<uint64_t>(nanosSince(opStart, Clock::now())));
+                live.push_back(orderId);
+                places++;
+            }
+            Clock::time_point opEnd = Clock::now();
+            response.record(static_cast<uint64_t>(nanosSince(start, opEnd) - scheduledNs));
+            if (!market.trades.empty()) {
+                fills += market.trades.size();
+                for (const Trade& trade : market.trades)
+                    mid[trade.productId] = trade.price;
+                market.trades.clear();
+            }
+
+            if (nanosSince(start, opEnd) >= nextSampleNs) {
+                int64_t bidQty = 0, askQty = 0;
+                for (int c = 1; c <= config.commodities; c++) {
+                    bidQty += market.restingAmount(c, OrderType::BUY);
+                    askQty += market.restingAmount(c, OrderType::SELL);
+                }
+                std::cout << std::fixed << std::setprecision(2)
+                    << std::setw(8) << nextSampleNs / 1e9 << std::setw(12) << places + cancels
+                    << std::setw(12) << market.orderCount() << std::setw(14) << bidQty
+                    << std::setw(14) << askQty << std::setw(12) << (nanosSince(start, opEnd) - scheduledNs) / 1e6 << "\n";
+                nextSampleNs += sampleNs;
+            }
+        }
+        double elapsed = nanosSince(start, Clock::now()) / 1e9;
+
+        uint64_t ops = places + cancels;
+        std::cout << std::setprecision(0) << "\nTarget " << config.rate << " ops/s, sustained "
+            << ops / elapsed << " ops/s (" << ops << " ops in " << std::setprecision(2) << elapsed
+            << " s), max lag " << maxLagNs / 1e6 << " ms\n";
+        std::cout << "Placed " << places << ", cancelled " << cancels << " (" << cancelMisses
+            << " already filled), fills " << fills << ", resting orders " << market.orderCount() << "\n\n";
+        std::cout << std::left << std::setw(18) << "latency (ns)" << std::right << std::setw(12) << "count"
+            << std::setw(12) << "p50" << std::setw(12) << "p99" << std::setw(12) << "p99.9"
+            << std::setw(14) << "max" << "\n";
+        printLatency("place (service)", placeService);
+        printLatency("cancel (service)", cancelService);
+        printLatency("all (response)", response);
+    }
+}
+
+int main(int argc, char** argv) {
+    LoadConfig config;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--rate")
+            config.rate = std::atof(argv[i + 1]);
+        else if (arg == "--seconds")
+            config.seconds = std::atof(argv[i + 1]);
+        else if (arg == "--commodities")
+            config.commodities = std::atoi(argv[i + 1]);
+        else if (arg == "--cancel-ratio")
+            config.cancelRatio = std::atof(argv[i + 1]);
+        else if (arg == "--size-alpha")
+            config.sizeAlpha = std::atof(argv[i + 1]);
+        else if (arg == "--max-size")
+            config.maxSize = std::atoi(argv[i + 1]);
+        else if (arg == "--offset-ticks")
+            config.offsetTicks = std::atof(argv[i + 1]);
+        else if (arg == "--sample-ms")
+            config.sampleMs = std::atoi(argv[i + 1]);
+        else if (arg == "--seed")
+            config.seed = static_cast<unsigned int>(std::strtoul(argv[i + 1], nullptr, 10));
+        else
+            std::cout << "Ignoring unknown option " << arg << "\n";
+    }
+    if (config.rate <= 0.0 || config.seconds <= 0.0 || config.commodities <= 0 || config.maxSize <= 0 ||
+        config.sizeAlpha <= 0.0 || config.offsetTicks < 0.0 || config.sampleMs <= 0 ||
+        config.cancelRatio < 0.0 || config.cancelRatio > 1.0) {
+        std::cout << "Invalid load configuration.\n";
+        return 1;
+    }
+    run(config);
+    return 0;
+}
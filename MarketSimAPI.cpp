@@ -0,0 +1,217 @@
+#include "MarketSimAPI.h"
+#include "Initialization.h"
+#include "AgentStrategies.h"
+#include "Simulation.h"
+#include "Log.h"
+#include <memory>
+
+// The views hand out pointers to the engine's own fields as fixed-width C types.
+static_assert(sizeof(int) == sizeof(int32_t), "engine ints must be 32-bit for the C views");
+static_assert(sizeof(Price) == sizeof(int64_t), "prices must be 64-bit ticks for the C views");
+static_assert(sizeof(OrderType) == sizeof(int32_t), "OrderType must be int-sized for the C views");
+static_assert(sizeof(CommodityType) == sizeof(int32_t), "CommodityType must be int-sized for the C views");
+static_assert(static_cast<int>(OrderType::BUY) == MSIM_BUY && static_cast<int>(OrderType::SELL) == MSIM_SELL,
+              "order side values must match the C API");
+static_assert(static_cast<int>(CommodityType::Resource) == MSIM_RESOURCE &&
+              static_cast<int>(CommodityType::Product) == MSIM_PRODUCT,
+              "commodity type values must match the C API");
+
+struct msim_world {
+    SimulationWorld world;
+    AgentPopulation agents;
+    std::unique_ptr<EventSimulation> simulation;
+    // The books are kept per product; msim_get_orders gathers them here for its view.
+    mutable std::vector<Order> orderView;
+    int day = 0;
+    bool logging = false;
+};
+
+namespace {
+    // The log switch is per thread; apply the world's setting for the duration of a call.
+    class LogScope {
+    public:
+        explicit LogScope(const msim_world* world) : previous(isLogEnabled()) { setLogEnabled(world->logging); }
+        ~LogScope() { setLogEnabled(previous); }
+    private:
+        bool previous;
+    };
+
+    template <typename T, typename Field>
+    const Field* fieldOf(const std::vector<T>& records, const Field T::* member) {
+        return records.empty() ? nullptr : &(records.front().*member);
+    }
+
+    void fillCommodityView(const std::vector<Commodity>& catalog, msim_commodity_view* view) {
+        view->count = catalog.size();
+        view->stride = sizeof(Commodity);
+        view->id = fieldOf(catalog, &Commodity::id);
+        view->price = fieldOf(catalog, &Commodity::price);
+        view->type = catalog.empty() ? nullptr : reinterpret_cast<const int32_t*>(&catalog.front().type);
+    }
+}
+
+int msim_api_version(void) {
+    return MSIM_API_VERSION;
+}
+
+int64_t msim_price_ticks_per_unit(void) {
+    return PRICE_TICKS_PER_UNIT;
+}
+
+msim_world* msim_world_create(uint32_t seed, const msim_config* config) {
+    try {
+        std::unique_ptr<msim_world> handle(new msim_world());
+        LogScope log(handle.get());
+        handle->world = initializeSimulation(seed);
+        IntradayConfig intraday;
+        if (config) {
+            if (config->intraday_orders_per_day < 0)
+                return nullptr;
+            intraday.orderArrivalsPerDay = config->intraday_orders_per_day;
+            if (config->plan_price_epsilon >= 0.0f)
+                handle->agents.lpController().setPriceEpsilon(config->plan_price_epsilon);
+        }
+        handle->simulation.reset(new EventSimulation(handle->world, handle->agents, intraday));
+        return handle.release();
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+void msim_world_destroy(msim_world* world) {
+    delete world;
+}
+
+void msim_world_set_logging(msim_world* world, int enabled) {
+    if (world)
+        world->logging = enabled != 0;
+}
+
+int msim_world_step(msim_world* world, int days) {
+    if (!world || days < 0)
+        return MSIM_ERROR_INVALID_ARGUMENT;
+    try {
+        LogScope log(world);
+        for (int i = 0; i < days; i++)
+            world->simulation->runDay(++world->day);
+        return world->day;
+    }
+    catch (...) {
+        return MSIM_ERROR_INTERNAL;
+    }
+}
+
+int msim_submit_orders(msim_world* world, const msim_order_request* orders, size_t count, int32_t* order_ids) {
+    if (!world || (!orders && count > 0))
+        return MSIM_ERROR_INVALID_ARGUMENT;
+    try {
+        LogScope log(world);
+        Market& market = world->world.market;
+        int placed = 0;
+        for (size_t i = 0; i < count; i++) {
+            const msim_order_request& request = orders[i];
+            // Owner 0 is the market itself, whose sells wait for the next matching pass.
+            if (request.amount <= 0 || request.owner_id <= 0 ||
+                (request.side != MSIM_BUY && request.side != MSIM_SELL))
+                break;
+            int id = request.side == MSIM_BUY
+                ? market.placeBuyOrder(request.product_id, request.amount, request.price, request.owner_id)
+                : market.placeSellOrder(request.product_id, request.amount, request.price, request.owner_id);
+            if (order_ids)
+                order_ids[i] = id;
+            placed++;
+        }
+        return placed;
+    }
+    catch (...) {
+        return MSIM_ERROR_INTERNAL;
+    }
+}
+
+int msim_cancel_order(msim_world* world, int32_t order_id, int32_t owner_id) {
+    if (!world)
+        return MSIM_ERROR_INVALID_ARGUMENT;
+    try {
+        LogScope log(world);
+        return world->world.market.removeOrder(order_id, owner_id) ? MSIM_OK : MSIM_ERROR_NOT_FOUND;
+    }
+    catch (...) {
+        return MSIM_ERROR_INTERNAL;
+    }
+}
+
+int msim_get_orders(const msim_world* world, msim_order_view* view) {
+    if (!world || !view)
+        return MSIM_ERROR_INVALID_ARGUMENT;
+    std::vector<Order>& orders = world->orderView;
+    try {
+        world->world.market.collectOrders(orders);
+    }
+    catch (...) {
+        return MSIM_ERROR_INTERNAL;
+    }
+    view->count = orders.size();
+    view->stride = sizeof(Order);
+    view->id = fieldOf(orders, &Order::id);
+    view->product_id = fieldOf(orders, &Order::productId);
+    view->side = orders.empty() ? nullptr : reinterpret_cast<const int32_t*>(&orders.front().type);
+    view->price = fieldOf(orders, &Order::price);
+    view->amount = fieldOf(orders, &Order::amount);
+    view->owner_id = fieldOf(orders, &Order::ownerId);
+    return MSIM_OK;
+}
+
+int msim_get_trades(const msim_world* world, msim_trade_view* view) {
+    if (!world || !view)
+        return MSIM_ERROR_INVALID_ARGUMENT;
+    const std::vector<Trade>& trades = world->world.market.trades;
+    view->count = trades.size();
+    view->stride = sizeof(Trade);
+    view->product_id = fieldOf(trades, &Trade::productId);
+    view->buy_order_id = fieldOf(trades, &Trade::buyOrderId);
+    view->sell_order_id = fieldOf(trades, &Trade::sellOrderId);
+    view->buyer_id = fieldOf(trades, &Trade::buyerId);
+    view->seller_id = fieldOf(trades, &Trade::sellerId);
+    view->amount = fieldOf(trades, &Trade::amount);
+    view->price = fieldOf(trades, &Trade::price);
+    return MSIM_OK;
+}
+
+int msim_get_resources(const msim_world* world, msim_commodity_view* view) {
+    if (!world || !view)
+        return MSIM_ERROR_INVALID_ARGUMENT;
+    fillCommodityView(world->world.resourceCatalog, view);
+    return MSIM_OK;
+}
+
+int msim_get_products(const msim_world* world, msim_commodity_view* view) {
+    if (!world || !view)
+        return MSIM_ERROR_INVALID_ARGUMENT;
+    fillCommodityView(world->world.productCatalog, view);
+    return MSIM_OK;
+}
+
+int msim_get_factories(const msim_world* world, msim_factory_view* view) {
+    if (!world || !view)
+        return MSIM_ERROR_INVALID_ARGUMENT;
+    const std::vector<Factory>& factories = world->world.aiFactories;
+    view->count = factories.size();
+    view->stride = sizeof(Factory);
+    view->id = fieldOf(factories, &Factory::id);
+    view->balance = fieldOf(factories, &Factory::balance);
+    view->capacity = fieldOf(factories, &Factory::capacity);
+    view->operating_cost = fieldOf(factories, &Factory::operatingCost);
+    return MSIM_OK;
+}
+
+int msim_get_inventory(const msim_world* world, size_t factory_index, msim_inventory_view* view) {
+    if (!world || !view || factory_index >= world->world.aiFactories.size())
+        return MSIM_ERROR_INVALID_ARGUMENT;
+    const auto& inventory = world->world.aiFactories[factory_index].inventory;
+    view->count = inventory.size();
+    view->stride = sizeof(inventory.front());
+    view->commodity_id = inventory.empty() ? nullptr : &inventory.front().first.id;
+    view->quantity = inventory.empty() ? nullptr : &inventory.front().second;
+    return MSIM_OK;
+}
@@ -0,0 +1,157 @@
+#pragma once
+/*
+ * C interface to the simulation core, built as the market_sim shared library.
+ *
+ * A world is created from a seed and stepped a day at a time: AI factory wakeups,
+ * optional intraday order flow and the closing price update, exactly as the game
+ * runs them after the player's turn. Callers can submit orders in batches and read
+ * the world through views.
+ *
+ * Views point straight into the engine's own arrays and copy nothing. Field i of a
+ * view is at ((const char*)field + i * stride). A view is valid until the next call
+ * that changes the same world: msim_world_step, msim_submit_orders, msim_cancel_order
+ * or msim_world_destroy.
+ *
+ * Prices and cash are int64 price ticks; msim_price_ticks_per_unit() gives the tick size.
+ *
+ * A world is not thread-safe. Different worlds may be used from different threads at
+ * the same time.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  if defined(MARKET_SIM_BUILDING_LIBRARY)
+#    define MSIM_API __declspec(dllexport)
+#  else
+#    define MSIM_API __declspec(dllimport)
+#  endif
+#else
+#  define MSIM_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Incremented whenever a declaration in this header changes incompatibly. */
+#define MSIM_API_VERSION 2
+
+/* Return codes. */
+#define MSIM_OK 0
+#define MSIM_ERROR_INVALID_ARGUMENT -1
+#define MSIM_ERROR_NOT_FOUND -2
+#define MSIM_ERROR_INTERNAL -3
+
+/* Order sides, matching the engine's OrderType values. */
+#define MSIM_BUY 0
+#define MSIM_SELL 1
+
+/* Commodity types, matching the engine's CommodityType values. */
+#define MSIM_RESOURCE 0
+#define MSIM_PRODUCT 1
+
+typedef struct msim_world msim_world;
+
+typedef struct msim_config {
+    int32_t intraday_orders_per_day; /* Outside orders per resource per day; 0 = none. */
+    float plan_price_epsilon;        /* AI plan reuse tolerance (relative); negative = default. */
+} msim_config;
+
+typedef struct msim_order_request {
+    int32_t product_id;
+    int32_t side;      /* MSIM_BUY or MSIM_SELL. */
+    int32_t amount;
+    int64_t price;     /* Limit price in ticks: the maximum for a BUY, the asking price for a SELL. */
+    int32_t owner_id;  /* Positive; use ids that no factory has (e.g. 1000000 and up). */
+} msim_order_request;
+
+/* Resting orders of every product: product by product (ascending id), each in time
+ * priority. msim_get_orders gathers them into one array on every call. */
+typedef struct msim_order_view {
+    size_t count;
+    size_t stride;
+    const int32_t* id;
+    const int32_t* product_id;
+    const int32_t* side;
+    const int64_t* price;
+    const int32_t* amount;
+    const int32_t* owner_id;
+} msim_order_view;
+
+/* Trades executed since the last price update, in execution order. */
+typedef struct msim_trade_view {
+    size_t count;
+    size_t stride;
+    const int32_t* product_id;
+    const int32_t* buy_order_id;
+    const int32_t* sell_order_id;
+    const int32_t* buyer_id;
+    const int32_t* seller_id;
+    const int32_t* amount;
+    const int64_t* price;
+} msim_trade_view;
+
+/* Resource or product catalog with current prices. */
+typedef struct msim_commodity_view {
+    size_t count;
+    size_t stride;
+    const int32_t* id;
+    const int64_t* price;
+    const int32_t* type;
+} msim_commodity_view;
+
+/* AI factories. */
+typedef struct msim_factory_view {
+    size_t count;
+    size_t stride;
+    const int32_t* id;
+    const int64_t* balance;
+    const int32_t* capacity;
+    const int64_t* operating_cost;
+} msim_factory_view;
+
+/* Inventory of one factory. */
+typedef struct msim_inventory_view {
+    size_t count;
+    size_t stride;
+    const int32_t* commodity_id;
+    const int32_t* quantity;
+} msim_inventory_view;
+
+MSIM_API int msim_api_version(void);
+
+/* Price ticks per currency unit (e.g. 100 when prices are in cents). */
+MSIM_API int64_t msim_price_ticks_per_unit(void);
+
+/* Generates a world from 'seed' (equal seeds give identical worlds). 'config' may be NULL
+ * for the defaults. Returns NULL on failure. The engine's console log is off. */
+MSIM_API msim_world* msim_world_create(uint32_t seed, const msim_config* config);
+MSIM_API void msim_world_destroy(msim_world* world);
+
+/* Turns the engine's console log on or off for calls made on this world. */
+MSIM_API void msim_world_set_logging(msim_world* world, int enabled);
+
+/* Simulates 'days' more days. Returns the number of days completed so far, or an error code. */
+MSIM_API int msim_world_step(msim_world* world, int days);
+
+/* Places 'count' orders in sequence; each may match immediately. If 'order_ids' is not
+ * NULL it receives the id of every placed order. Returns the number of orders placed,
+ * which is less than 'count' only if a request was invalid (placing stops there). */
+MSIM_API int msim_submit_orders(msim_world* world, const msim_order_request* orders, size_t count,
+                                int32_t* order_ids);
+
+/* Removes a resting order. Returns MSIM_OK, or MSIM_ERROR_NOT_FOUND if no order with that
+ * id belongs to 'owner_id'. */
+MSIM_API int msim_cancel_order(msim_world* world, int32_t order_id, int32_t owner_id);
+
+MSIM_API int msim_get_orders(const msim_world* world, msim_order_view* view);
+MSIM_API int msim_get_trades(const msim_world* world, msim_trade_view* view);
+MSIM_API int msim_get_resources(const msim_world* world, msim_commodity_view* view);
+MSIM_API int msim_get_products(const msim_world* world, msim_commodity_view* view);
+MSIM_API int msim_get_factories(const msim_world* world, msim_factory_view* view);
+MSIM_API int msim_get_inventory(const msim_world* world, size_t factory_index, msim_inventory_view* view);
+
+#ifdef __cplusplus
+}
+#endif
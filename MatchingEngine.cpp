@@ -0,0 +1,130 @@
+#include "MatchingEngine.h"
+#include "Log.h"
+#include <chrono>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+MatchingEngine::MatchingEngine(Market& market, size_t queueCapacity, int cpu)
+    : market(market), commands(queueCapacity), acks(queueCapacity),
+      running(false), processed(0), nextSequence(0), cpu(cpu), logging(true) {}
+
+MatchingEngine::~MatchingEngine() {
+    stop();
+}
+
+int64_t MatchingEngine::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void MatchingEngine::start() {
+    if (running.exchange(true))
+        return;
+    logging = isLogEnabled();
+    worker = std::thread(&MatchingEngine::run, this);
+}
+
+void MatchingEngine::stop() {
+    if (!running.exchange(false))
+        return;
+    if (worker.joinable())
+        worker.join();
+}
+
+bool MatchingEngine::submit(OrderCommand command) {
+    command.enqueueNs = nowNs();
+    return commands.push(command);
+}
+
+bool MatchingEngine::pollAck(CommandAck& ack) {
+    return acks.pop(ack);
+}
+
+void MatchingEngine::pinToCpu() {
+    if (cpu < 0)
+        return;
+#if defined(_WIN32)
+    SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << cpu);
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+        simLog() << "MatchingEngine: could not pin matching thread to CPU " << cpu << "\n";
+#endif
+}
+
+void MatchingEngine::run() {
+    setLogEnabled(logging);
+    pinToCpu();
+    OrderCommand command;
+    while (true) {
+        if (commands.pop(command)) {
+            apply(command);
+            continue;
+        }
+        // Queue is empty: exit once asked to stop, otherwise keep polling.
+        if (!running.load(std::memory_order_acquire)) {
+            // A producer may have pushed between the failed pop and the stop request.
+            if (commands.pop(command)) {
+                apply(command);
+                continue;
+            }
+            break;
+        }
+        std::this_thread::yield();
+    }
+}
+
+void MatchingEngine::apply(const OrderCommand& command) {
+    CommandAck ack;
+    ack.sequence = nextSequence++;
+    ack.clientTag = command.clientTag;
+    ack.type = command.type;
+    ack.ownerId = command.ownerId;
+    ack.orderId = command.orderId;
+    ack.accepted = true;
+    ack.filledAmount = 0;
+    ack.enqueueNs = command.enqueueNs;
+
+    // Only the command's own trades are inspected; they are summed into the ack and then
+    // dropped, so market.trades does not grow for as long as the engine runs.
+    size_t firstTrade = market.trades.size();
+    switch (command.type) {
+    case CommandType::BUY:
+        ack.orderId = market.placeBuyOrder(command.productId, command.amount, command.price, command.ownerId);
+        break;
+    case CommandType::SELL:
+        ack.orderId = market.placeSellOrder(command.productId, command.amount, command.price, command.ownerId);
+        break;
+    case CommandType::CANCEL:
+        ack.accepted = market.removeOrder(command.orderId, command.ownerId);
+        break;
+    case CommandType::AMEND:
+        ack.accepted = market.amendOrder(command.orderId, command.ownerId, command.amount, command.price);
+        break;
+    }
+    for (size_t i = firstTrade; i < market.trades.size(); i++) {
+        const Trade& trade = market.trades[i];
+        if (trade.buyOrderId == ack.orderId || trade.sellOrderId == ack.orderId)
+            ack.filledAmount += trade.amount;
+    }
+    market.trades.erase(market.trades.begin() + firstTrade, market.trades.end());
+    ack.ackNs = nowNs();
+
+    // Publish the ack; if the consumer has fallen behind, wait rather than drop it
+    // (unless the engine is shutting down and nobody may be draining acks any more).
+    while (!acks.push(ack)) {
+        if (!running.load(std::memory_order_acquire))
+            break;
+        std::this_thread::yield();
+    }
+    processed.fetch_add(1, std::memory_order_release);
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "Market.h"
+#include "OrderQueue.h"
+
+// Commands that producers can send to the matching thread.
+enum class CommandType { BUY, SELL, CANCEL, AMEND };
+
+struct OrderCommand {
+    CommandType type;
+    int productId;      // Ignored for CANCEL and AMEND.
+    int amount;         // New quantity for AMEND; ignored for CANCEL.
+    Price price;        // Max price for BUY, asking price for SELL, new price for AMEND; ignored for CANCEL.
+    int ownerId;
+    int orderId;        // Order to cancel or amend; ignored for BUY/SELL.
+    uint64_t clientTag; // Opaque value echoed back in the ack.
+    int64_t enqueueNs;  // Filled in by MatchingEngine::submit.
+};
+
+// Result of applying one command, published by the matching thread.
+struct CommandAck {
+    uint64_t sequence;  // Arrival sequence number of the command (0, 1, 2, ...).
+    uint64_t clientTag;
+    CommandType type;
+    int ownerId;
+    int orderId;        // Id assigned to the new order, or the cancelled or amended order's id.
+    bool accepted;      // False if a CANCEL or AMEND did not find an order belonging to the owner.
+    int filledAmount;   // Quantity of this order that traded while the command was applied.
+                        // The trades themselves are not kept in market.trades.
+    int64_t enqueueNs;
+    int64_t ackNs;      // Time the command finished applying; ackNs - enqueueNs is its latency.
+};
+
+// Sequencer in front of a Market: any number of producer threads submit commands into a
+// lock-free MPSC queue and a single (optionally CPU-pinned) matching thread applies them to
+// the order book in arrival order. While the engine is running, the Market must not be
+// touched by any other thread.
+class MatchingEngine {
+public:
+    // 'cpu' selects the core to pin the matching thread to; -1 leaves it unpinned.
+    MatchingEngine(Market& market, size_t queueCapacity = 65536, int cpu = -1);
+    ~MatchingEngine();
+
+    MatchingEngine(const MatchingEngine&) = delete;
+    MatchingEngine& operator=(const MatchingEngine&) = delete;
+
+    // Starts the matching thread. It logs (simLog) only if the calling thread does.
+    void start();
+
+    // Stops the matching thread after it has applied every command already submitted.
+    void stop();
+
+    // Enqueues a command. Thread-safe and lock-free. Returns false if the queue is full.
+    bool submit(OrderCommand command);
+
+    // Retrieves the next ack. Must only be called from one consumer thread at a time.
+    // Returns false if no ack is available.
+    bool pollAck(CommandAck& ack);
+
+    // Number of commands applied so far.
+    uint64_t processedCount() const { return processed.load(std::memory_order_acquire); }
+
+    // Monotonic timestamp in nanoseconds used for enqueue/ack times.
+    static int64_t nowNs();
+
+private:
+    void run();
+    void apply(const OrderCommand& command);
+    void pinToCpu();
+
+    Market& market;
+    MpscQueue<OrderCommand> commands;
+    MpscQueue<CommandAck> acks;
+    std::thread worker;
+    std::atomic<bool> running;
+    std::atomic<uint64_t> processed;
+    uint64_t nextSequence;
+    int cpu;
+    bool logging;
+};
@@ -0,0 +1,266 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+const char* metricCounterName(MetricCounter counter) {
+    switch (counter) {
+    case MetricCounter::OrdersPlaced: return "orders_placed";
+    case MetricCounter::Fills: return "fills";
+    case MetricCounter::Cancels: return "cancels";
+    case MetricCounter::LpPivots: return "lp_pivots";
+    case MetricCounter::Events: return "events";
+    case MetricCounter::PlansReused: return "plans_reused";
+    case MetricCounter::AgentResumes: return "agent_resumes";
+    case MetricCounter::PlanBudgetHits: return "plan_budget_hits";
+    default: return "unknown";
+    }
+}
+
+const char* metricPhaseName(MetricPhase phase) {
+    switch (phase) {
+    case MetricPhase::OrderEntry: return "order_entry";
+    case MetricPhase::Matching: return "matching";
+    case MetricPhase::LpSolve: return "lp_solve";
+    case MetricPhase::PlayerTurn: return "player_turn";
+    case MetricPhase::AiTurn: return "ai_turn";
+    case MetricPhase::PriceUpdate: return "price_update";
+    default: return "unknown";
+    }
+}
+
+// --- LatencyHistogram ---
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+void LatencyHistogram::reset() {
+    std::fill(buckets, buckets + NUM_BUCKETS, 0);
+    total = 0;
+    sumNs = 0;
+    maxNs = 0;
+}
+
+static int highestBit(uint64_t value) {
+    int bit = 0;
+    while (value >>= 1)
+        bit++;
+    return bit;
+}
+
+int LatencyHistogram::bucketIndex(uint64_t value) {
+    // Values below 2 * SUB_BUCKETS get a bucket each; above that, the top five bits of the
+    // value select the sub-bucket within its power-of-two range.
+    if (value < 2 * SUB_BUCKETS)
+        return static_cast<int>(value);
+    int shift = highestBit(value) - 4;
+    int index = shift * SUB_BUCKETS + static_cast<int>(value >> shift);
+    return std::min(index, NUM_BUCKETS - 1);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int index) {
+    if (index < 2 * SUB_BUCKETS)
+        return static_cast<uint64_t>(index);
+    int shift = index / SUB_BUCKETS - 1;
+    uint64_t sub = static_cast<uint64_t>(index % SUB_BUCKETS + SUB_BUCKETS);
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t valueNs) {
+    buckets[bucketIndex(valueNs)]++;
+    total++;
+    sumNs += valueNs;
+    if (valueNs > maxNs)
+        maxNs = valueNs;
+}
+
+void LatencyHistogram::add(const LatencyHistogram& other) {
+    for (int i = 0; i < NUM_BUCKETS; i++)
+        buckets[i] += other.buckets[i];
+    total += other.total;
+    sumNs += other.sumNs;
+    maxNs = std::max(maxNs, other.maxNs);
+}
+
+void LatencyHistogram::subtract(const LatencyHistogram& earlier) {
+    int highest = -1;
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        buckets[i] -= earlier.buckets[i];
+        if (buckets[i] > 0)
+            highest = i;
+    }
+    total -= earlier.total;
+    sumNs -= earlier.sumNs;
+    // The exact maximum of the difference is not known; the top non-empty bucket bounds it.
+    maxNs = highest < 0 ? 0 : std::min(bucketUpperBound(highest), maxNs);
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    if (total == 0)
+        return 0;
+    uint64_t rank = static_cast<uint64_t>(p * (total - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= rank)
+            return std::min(bucketUpperBound(i), maxNs);
+    }
+    return maxNs;
+}
+
+// --- Registry ---
+
+namespace {
+    // One per thread. Only the owning thread writes, so updates are plain relaxed
+    // load/store pairs; snapshot() reads them from other threads.
+    struct MetricsShard {
+        std::atomic<uint64_t> counters[NUM_METRIC_COUNTERS];
+        std::atomic<uint64_t> buckets[NUM_METRIC_PHASES][LatencyHistogram::NUM_BUCKETS];
+        std::atomic<uint64_t> totals[NUM_METRIC_PHASES];
+        std::atomic<uint64_t> sums[NUM_METRIC_PHASES];
+        std::atomic<uint64_t> maxima[NUM_METRIC_PHASES];
+
+        MetricsShard() {
+            for (auto& c : counters) c.store(0, std::memory_order_relaxed);
+            for (auto& phase : buckets)
+                for (auto& b : phase) b.store(0, std::memory_order_relaxed);
+            for (auto& t : totals) t.store(0, std::memory_order_relaxed);
+            for (auto& s : sums) s.store(0, std::memory_order_relaxed);
+            for (auto& m : maxima) m.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    inline void bump(std::atomic<uint64_t>& cell, uint64_t amount) {
+        cell.store(cell.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    // Shards outlive their threads so that counts from finished threads are kept.
+    std::mutex shardsMutex;
+    std::vector<std::unique_ptr<MetricsShard>>& allShards() {
+        static std::vector<std::unique_ptr<MetricsShard>> shards;
+        return shards;
+    }
+
+    MetricsShard& localShard() {
+        thread_local MetricsShard* shard = nullptr;
+        if (!shard) {
+            std::lock_guard<std::mutex> lock(shardsMutex);
+            allShards().push_back(std::make_unique<MetricsShard>());
+            shard = allShards().back().get();
+        }
+        return *shard;
+    }
+}
+
+void Metrics::increment(MetricCounter counter, uint64_t amount) {
+    bump(localShard().counters[static_cast<int>(counter)], amount);
+}
+
+void Metrics::record(MetricPhase phase, uint64_t valueNs) {
+    MetricsShard& shard = localShard();
+    int p = static_cast<int>(phase);
+    bump(shard.buckets[p][LatencyHistogram::bucketIndex(valueNs)], 1);
+    bump(shard.totals[p], 1);
+    bump(shard.sums[p], valueNs);
+    if (valueNs > shard.maxima[p].load(std::memory_order_relaxed))
+        shard.maxima[p].store(valueNs, std::memory_order_relaxed);
+}
+
+MetricsSnapshot Metrics::snapshot() {
+    MetricsSnapshot snap;
+    std::lock_guard<std::mutex> lock(shardsMutex);
+    for (const auto& shard : allShards()) {
+        for (int c = 0; c < NUM_METRIC_COUNTERS; c++)
+            snap.counters[c] += shard->counters[c].load(std::memory_order_relaxed);
+        for (int p = 0; p < NUM_METRIC_PHASES; p++) {
+            LatencyHistogram& hist = snap.phases[p];
+            for (int b = 0; b < LatencyHistogram::NUM_BUCKETS; b++)
+                hist.buckets[b] += shard->buckets[p][b].load(std::memory_order_relaxed);
+            hist.total += shard->totals[p].load(std::memory_order_relaxed);
+            hist.sumNs += shard->sums[p].load(std::memory_order_relaxed);
+            hist.maxNs = std::max(hist.maxNs, shard->maxima[p].load(std::memory_order_relaxed));
+        }
+    }
+    return snap;
+}
+
+// --- DailyStatsWriter ---
+
+bool DailyStatsWriter::openCsv(const std::string& path) {
+    csv.open(path);
+    if (!csv)
+        return false;
+    writeCsvHeader();
+    return true;
+}
+
+bool DailyStatsWriter::openJson(const std::string& path) {
+    json.open(path);
+    return static_cast<bool>(json);
+}
+
+void DailyStatsWriter::writeCsvHeader() {
+    csv << "day";
+    for (int c = 0; c < NUM_METRIC_COUNTERS; c++)
+        csv << "," << metricCounterName(static_cast<MetricCounter>(c));
+    for (int p = 0; p < NUM_METRIC_PHASES; p++) {
+        const char* name = metricPhaseName(static_cast<MetricPhase>(p));
+        csv << "," << name << "_count"
+            << "," << name << "_mean_ns"
+            << "," << name << "_p50_ns"
+            << "," << name << "_p99_ns"
+            << "," << name << "_max_ns";
+    }
+    csv << "\n";
+}
+
+void DailyStatsWriter::recordDay(int day) {
+    MetricsSnapshot current = Metrics::snapshot();
+    MetricsSnapshot delta = current;
+    for (int c = 0; c < NUM_METRIC_COUNTERS; c++)
+        delta.counters[c] -= previous.counters[c];
+    for (int p = 0; p < NUM_METRIC_PHASES; p++)
+        delta.phases[p].subtract(previous.phases[p]);
+    previous = current;
+
+    if (csv.is_open()) {
+        csv << day;
+        for (int c = 0; c < NUM_METRIC_COUNTERS; c++)
+            csv << "," << delta.counters[c];
+        for (int p = 0; p < NUM_METRIC_PHASES; p++) {
+            const LatencyHistogram& h = delta.phases[p];
+            csv << "," << h.count()
+                << "," << static_cast<uint64_t>(h.mean())
+                << "," << h.percentile(0.50)
+                << "," << h.percentile(0.99)
+                << "," << h.max();
+        }
+        csv << "\n";
+        csv.flush();
+    }
+
+    if (json.is_open()) {
+        json << "{\"day\":" << day << ",\"counters\":{";
+        for (int c = 0; c < NUM_METRIC_COUNTERS; c++) {
+            json << (c ? "," : "") << "\"" << metricCounterName(static_cast<MetricCounter>(c)) << "\":"
+                << delta.counters[c];
+        }
+        json << "},\"phases\":{";
+        for (int p = 0; p < NUM_METRIC_PHASES; p++) {
+            const LatencyHistogram& h = delta.phases[p];
+            json << (p ? "," : "") << "\"" << metricPhaseName(static_cast<MetricPhase>(p)) << "\":{"
+                << "\"count\":" << h.count()
+                << ",\"mean_ns\":" << static_cast<uint64_t>(h.mean())
+                << ",\"p50_ns\":" << h.percentile(0.50)
+                << ",\"p90_ns\":" << h.percentile(0.90)
+                << ",\"p99_ns\":" << h.percentile(0.99)
+                << ",\"p999_ns\":" << h.percentile(0.999)
+                << ",\"max_ns\":" << h.max() << "}";
+        }
+        json << "}}\n";
+        json.flush();
+    }
+}
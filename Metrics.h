@@ -0,0 +1,134 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// Compile-time switch for the instrumentation. With MARKET_SIM_METRICS set to 0 the
+// METRICS_* macros expand to nothing and the engines carry no metrics code at all.
+#ifndef MARKET_SIM_METRICS
+#define MARKET_SIM_METRICS 1
+#endif
+
+enum class MetricCounter {
+    OrdersPlaced,
+    Fills,
+    Cancels,
+    LpPivots,
+    Events,
+    PlansReused,
+    AgentResumes,
+    PlanBudgetHits,
+    Count
+};
+
+enum class MetricPhase {
+    OrderEntry,   // Market::placeBuyOrder / placeSellOrder, including matching.
+    Matching,     // Market::matchOrders.
+    LpSolve,      // Simplex::solve.
+    PlayerTurn,   // PlayerController::takeTurn.
+    AiTurn,       // AIController::updateFactory.
+    PriceUpdate,  // updateMarketPrices.
+    Count
+};
+
+const int NUM_METRIC_COUNTERS = static_cast<int>(MetricCounter::Count);
+const int NUM_METRIC_PHASES = static_cast<int>(MetricPhase::Count);
+
+const char* metricCounterName(MetricCounter counter);
+const char* metricPhaseName(MetricPhase phase);
+
+// HDR-style latency histogram: every power-of-two range is split into 16 linear sub-buckets,
+// so any recorded value is reported within about 6% while covering 1 ns to hours in
+// under a thousand buckets.
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKETS = 16;
+    static const int NUM_BUCKETS = 60 * SUB_BUCKETS;
+
+    LatencyHistogram();
+
+    void record(uint64_t valueNs);
+    void add(const LatencyHistogram& other);
+    // Bucket-wise difference; 'earlier' must be a previous state of this histogram.
+    void subtract(const LatencyHistogram& earlier);
+    void reset();
+
+    uint64_t count() const { return total; }
+    uint64_t sum() const { return sumNs; }
+    uint64_t max() const { return maxNs; }
+    double mean() const { return total ? static_cast<double>(sumNs) / total : 0.0; }
+    // Upper bound of the bucket holding the p-th quantile (p in [0, 1]).
+    uint64_t percentile(double p) const;
+
+    static int bucketIndex(uint64_t value);
+    static uint64_t bucketUpperBound(int index);
+
+    uint64_t buckets[NUM_BUCKETS];
+    uint64_t total;
+    uint64_t sumNs;
+    uint64_t maxNs;
+};
+
+// Merged view of all threads' metrics at one point in time.
+struct MetricsSnapshot {
+    uint64_t counters[NUM_METRIC_COUNTERS] = {};
+    LatencyHistogram phases[NUM_METRIC_PHASES];
+};
+
+// Process-wide metrics registry. Every thread writes to its own shard, so recording is a
+// couple of uncontended stores; snapshot() sums the shards.
+class Metrics {
+public:
+    static void increment(MetricCounter counter, uint64_t amount = 1);
+    static void record(MetricPhase phase, uint64_t valueNs);
+    static MetricsSnapshot snapshot();
+};
+
+// Records the lifetime of a scope into a phase histogram.
+class ScopedMetricTimer {
+public:
+    explicit ScopedMetricTimer(MetricPhase phase)
+        : phase(phase), start(std::chrono::steady_clock::now()) {}
+    ~ScopedMetricTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        Metrics::record(phase, static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+    ScopedMetricTimer(const ScopedMetricTimer&) = delete;
+    ScopedMetricTimer& operator=(const ScopedMetricTimer&) = delete;
+
+private:
+    MetricPhase phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define METRICS_CONCAT_INNER(a, b) a##b
+#define METRICS_CONCAT(a, b) METRICS_CONCAT_INNER(a, b)
+
+#if MARKET_SIM_METRICS
+#define METRICS_COUNT(counter, amount) Metrics::increment(counter, amount)
+#define METRICS_TIME(phase) ScopedMetricTimer METRICS_CONCAT(metricTimer_, __LINE__)(phase)
+#else
+#define METRICS_COUNT(counter, amount) ((void)0)
+#define METRICS_TIME(phase) ((void)0)
+#endif
+
+// Writes one row per simulated day with that day's counter deltas and per-phase latency
+// statistics, as CSV and/or JSON Lines (one JSON object per line).
+class DailyStatsWriter {
+public:
+    bool openCsv(const std::string& path);
+    bool openJson(const std::string& path);
+    bool isOpen() const { return csv.is_open() || json.is_open(); }
+
+    // Records everything measured since the previous call (or since start-up).
+    void recordDay(int day);
+
+private:
+    void writeCsvHeader();
+
+    std::ofstream csv;
+    std::ofstream json;
+    MetricsSnapshot previous;
+};
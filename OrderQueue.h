@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Bounded lock-free multi-producer / single-consumer ring buffer.
+// Each slot carries a sequence number that tells producers and the consumer whether the
+// slot is free or holds a published value, so no locks are taken on either side.
+// The order in which producers claim slots is the order in which the consumer sees them.
+template <typename T>
+class MpscQueue {
+public:
+    // Capacity is rounded up to the next power of two.
+    explicit MpscQueue(size_t requestedCapacity) {
+        capacity = 1;
+        while (capacity < requestedCapacity)
+            capacity <<= 1;
+        mask = capacity - 1;
+        slots.reset(new Slot[capacity]);
+        for (size_t i = 0; i < capacity; i++)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+        head = 0;
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Safe to call from any number of threads. Returns false if the queue is full.
+    // On success, 'position' receives the slot ticket, which is the arrival sequence.
+    bool push(const T& value, size_t* position = nullptr) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots[pos & mask];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                // The slot is free for this ticket; try to claim it.
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0) {
+                // The consumer has not freed this slot yet: the queue is full.
+                return false;
+            }
+            else {
+                // Another producer claimed the ticket first.
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+        Slot& slot = slots[pos & mask];
+        slot.value = value;
+        slot.sequence.store(pos + 1, std::memory_order_release);
+        if (position)
+            *position = pos;
+        return true;
+    }
+
+    // Must only be called from the single consumer thread. Returns false if the queue is empty.
+    bool pop(T& out) {
+        Slot& slot = slots[head & mask];
+        size_t seq = slot.sequence.load(std::memory_order_acquire);
+        if (seq != head + 1)
+            return false;
+        out = slot.value;
+        // Hand the slot back to producers for the ticket one lap ahead.
+        slot.sequence.store(head + capacity, std::memory_order_release);
+        head++;
+        return true;
+    }
+
+    size_t getCapacity() const { return capacity; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    size_t capacity;
+    size_t mask;
+    std::unique_ptr<Slot[]> slots;
+    // Producers and the consumer live on separate cache lines to avoid false sharing.
+    alignas(64) std::atomic<size_t> tail;
+    alignas(64) size_t head;
+};
@@ -1,5 +1,6 @@
 #include "PlayerController.h"
 #include "Initialization.h"  // For SimulationWorld, Factory, Market, Commodity, and Equipment
+#include "Metrics.h"
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
@@ -17,11 +18,11 @@ static void viewProductMarket(const Market& market, const std::vector<Commodity>
 
     // For each product, calculate best buy and best sell.
     for (const auto& prod : productCatalog) {
-        float bestBuyPrice = 0.0f;
+        Price bestBuyPrice = 0;
         int bestBuyQty = 0;
         // For BUY orders: highest price wins.
-        for (const auto& order : market.orders) {
-            if (order.productId == prod.id && order.type == OrderType::BUY) {
+        for (const auto& order : market.book(prod.id)) {
+            if (order.type == OrderType::BUY) {
                 if (order.price > bestBuyPrice) {
                     bestBuyPrice = order.price;
                     bestBuyQty = order.amount;
@@ -32,12 +33,12 @@ static void viewProductMarket(const Market& market, const std::vector<Commodity>
             }
         }
 
-        float bestSellPrice = 0.0f;
+        Price bestSellPrice = 0;
         int bestSellQty = 0;
         bool foundSell = false;
         // For SELL orders: lowest price wins.
-        for (const auto& order : market.orders) {
-            if (order.productId == prod.id && order.type == OrderType::SELL) {
+        for (const auto& order : market.book(prod.id)) {
+            if (order.type == OrderType::SELL) {
                 if (!foundSell || order.price < bestSellPrice) {
                     bestSellPrice = order.price;
                     bestSellQty = order.amount;
@@ -49,13 +50,13 @@ static void viewProductMarket(const Market& market, const std::vector<Commodity>
             }
         }
         if (!foundSell) {
-            bestSellPrice = 0.0f;
+            bestSellPrice = 0;
             bestSellQty = 0;
         }
 
         std::cout << std::left << std::setw(15) << prod.name
-            << " | " << std::right << std::setw(6) << bestBuyPrice << " (" << std::setw(3) << bestBuyQty << ")"
-            << " | " << std::setw(6) << bestSellPrice << " (" << std::setw(3) << bestSellQty << ")\n";
+            << " | " << std::right << std::setw(6) << formatPrice(bestBuyPrice) << " (" << std::setw(3) << bestBuyQty << ")"
+            << " | " << std::setw(6) << formatPrice(bestSellPrice) << " (" << std::setw(3) << bestSellQty << ")\n";
     }
 }
 
@@ -68,11 +69,11 @@ static void viewResourceMarket(const Market& market, const std::vector<Commodity
 
     // For each resource, find the best (lowest) SELL order.
     for (const auto& res : resourceCatalog) {
-        float bestSellPrice = 0.0f;
+        Price bestSellPrice = 0;
         int bestSellQty = 0;
         bool foundSell = false;
-        for (const auto& order : market.orders) {
-            if (order.productId == res.id && order.type == OrderType::SELL) {
+        for (const auto& order : market.book(res.id)) {
+            if (order.type == OrderType::SELL) {
                 if (!foundSell || order.price < bestSellPrice) {
                     bestSellPrice = order.price;
                     bestSellQty = order.amount;
@@ -84,11 +85,11 @@ static void viewResourceMarket(const Market& market, const std::vector<Commodity
             }
         }
         if (!foundSell) {
-            bestSellPrice = 0.0f;
+            bestSellPrice = 0;
             bestSellQty = 0;
         }
         std::cout << std::left << std::setw(15) << res.name
-            << " | " << std::right << std::setw(6) << bestSellPrice
+            << " | " << std::right << std::setw(6) << formatPrice(bestSellPrice)
             << " (" << std::setw(3) << bestSellQty << ")\n";
     }
 }
@@ -104,26 +105,28 @@ static void viewEquipmentCatalog(const std::vector<Equipment>& equipCatalog) {
     std::cout << std::string(60, '-') << "\n";
     for (const auto& equip : equipCatalog) {
         std::cout << std::left << std::setw(12) << equip.id
-            << " | " << std::right << std::setw(10) << equip.price << "  "
+            << " | " << std::right << std::setw(10) << formatPrice(equip.price) << "  "
             << " | " << std::setw(12) << equip.output_rate
-            << " | " << std::setw(16) << equip.operational_cost << "\n";
+            << " | " << std::setw(16) << formatPrice(equip.operational_cost) << "\n";
     }
 }
 
-// Helper function: View full Product Catalog (with recipes and equipment requirements)
-static void viewProductCatalog(const std::vector<Commodity>& productCatalog) {
+// Helper function: View full Product Catalog (with recipes, equipment requirements and costs)
+static void viewProductCatalog(const std::vector<Commodity>& productCatalog, ProductionGraph& graph) {
     std::cout << "\n--- Product Catalog ---\n";
     for (const auto& prod : productCatalog) {
         std::cout << "Product: " << prod.name
             << " (ID: " << prod.id
-            << ", Price: " << prod.price << ")\n";
-        std::cout << "  Resources:\n";
+            << ", Price: " << formatPrice(prod.price) << ")\n";
+        std::cout << "  Raw material cost: " << formatPrice(graph.rawMaterialCost(prod.id))
+            << " | Marginal cost: " << formatPrice(graph.marginalCost(prod.id)) << "\n";
+        std::cout << "  Ingredients:\n";
         if (prod.recipe.empty()) {
             std::cout << "    None\n";
         }
         else {
             for (const auto& req : prod.recipe) {
-                std::cout << "    Resource " << std::setw(3) << req.first
+                std::cout << "    " << (graph.isProduct(req.first) ? "Product " : "Resource") << " " << std::setw(3) << req.first
                     << "  x " << std::setw(2) << req.second << "\n";
             }
         }
@@ -144,32 +147,31 @@ static void viewProductCatalog(const std::vector<Commodity>& productCatalog) {
 // Helper function: View all orders for a specific commodity.
 static void viewMarketOrdersForCommodity(const Market& market, int commodityId) {
     std::cout << "\n--- Market Orders for Commodity " << commodityId << " ---\n";
-    for (const auto& order : market.orders) {
-        if (order.productId == commodityId) {
-            std::cout << "Order ID " << order.id
-                << ", " << (order.type == OrderType::BUY ? "BUY" : "SELL")
-                << ", Price: " << order.price
-                << ", Amount: " << order.amount << "\n";
-        }
+    for (const auto& order : market.book(commodityId)) {
+        std::cout << "Order ID " << order.id
+            << ", " << (order.type == OrderType::BUY ? "BUY" : "SELL")
+            << ", Price: " << formatPrice(order.price)
+            << ", Amount: " << order.amount << "\n";
     }
 }
 
 // Helper function: Handle buying a commodity.
 static void buyCommodity(Factory& player, Market& market) {
     int commodityId, amount;
-    float maxPrice;
+    double maxPriceInput;
     char fullPurchase;
 
     std::cout << "Enter commodity ID, desired amount, and maximum price: ";
-    std::cin >> commodityId >> amount >> maxPrice;
+    std::cin >> commodityId >> amount >> maxPriceInput;
+    Price maxPrice = toPrice(maxPriceInput);
     std::cout << "Full purchase only? (y/n): ";
     std::cin >> fullPurchase;
 
     // If full purchase is required, check that enough supply is available.
     if (std::toupper(fullPurchase) == 'Y') {
         int available = 0;
-        for (const auto& order : market.orders) {
-            if (order.productId == commodityId && order.type == OrderType::SELL && order.price <= maxPrice)
+        for (const auto& order : market.book(commodityId)) {
+            if (order.type == OrderType::SELL && order.price <= maxPrice)
                 available += order.amount;
         }
         if (available < amount) {
@@ -184,7 +186,7 @@ static void buyCommodity(Factory& player, Market& market) {
     // For this simulation, assume instant full execution of the buy order.
     // Update the player's inventory by adding exactly 'amount' units.
     bool found = false;
-    for (auto& item : player.inventory) {
+    for (auto& item : player.inventory.write()) {
         if (item.first.id == commodityId) {
             item.second += amount;
             found = true;
@@ -199,7 +201,7 @@ static void buyCommodity(Factory& player, Market& market) {
         commodity.name = "Commodity " + std::to_string(commodityId);
         // Assume it's a Resource (or set type appropriately).
         commodity.type = CommodityType::Resource;
-        player.inventory.push_back({ commodity, amount });
+        player.inventory.write().push_back({ commodity, amount });
     }
     std::cout << "Purchased " << amount << " units of commodity " << commodityId << ".\n";
 }
@@ -207,13 +209,14 @@ static void buyCommodity(Factory& player, Market& market) {
 // Helper function: Handle selling a commodity.
 static void sellCommodity(Factory& player, Market& market) {
     int commodityId, amount;
-    float price;
+    double priceInput;
 
     std::cout << "Enter commodity ID, amount, and price: ";
-    std::cin >> commodityId >> amount >> price;
+    std::cin >> commodityId >> amount >> priceInput;
+    Price price = toPrice(priceInput);
 
     // Check if the player has enough of the commodity.
-    for (auto& item : player.inventory) {
+    for (auto& item : player.inventory.write()) {
         if (item.first.id == commodityId) {
             if (item.second < amount) {
                 std::cout << "Insufficient quantity in inventory. Order not placed.\n";
@@ -253,7 +256,7 @@ static void purchaseEquipment(Factory& player, const std::vector<Equipment>& equ
         return;
     }
 
-    float totalCost = selectedEquip->price * qty;
+    Price totalCost = selectedEquip->price * qty;
     if (player.balance < totalCost) {
         std::cout << "Insufficient balance to purchase " << qty << " units of Equipment " << equipId << ".\n";
         return;
@@ -261,10 +264,8 @@ static void purchaseEquipment(Factory& player, const std::vector<Equipment>& equ
 
     player.balance -= totalCost;
     // Add the equipment units to the player's inventory.
-    for (int i = 0; i < qty; i++) {
-        player.equipment.push_back(*selectedEquip);
-    }
-    std::cout << "Purchased " << qty << " units of Equipment " << equipId << " for a total of " << totalCost << ".\n";
+    player.addEquipment(*selectedEquip, qty);
+    std::cout << "Purchased " << qty << " units of Equipment " << equipId << " for a total of " << formatPrice(totalCost) << ".\n";
 }
 
 // Helper function: View the player's inventory.
@@ -302,23 +303,28 @@ static void viewInventory(const Factory& factory) {
     }
 
     // Equipment Section
-    std::cout << "\nEquipment Owned (" << factory.equipment.size() << "):\n";
+    int unitsOwned = 0;
+    for (const auto& holding : factory.equipment)
+        unitsOwned += holding.count;
+    std::cout << "\nEquipment Owned (" << unitsOwned << " units, capacity " << factory.capacity << "/day):\n";
     if (factory.equipment.empty()) {
         std::cout << "  None\n";
     }
     else {
-        for (size_t i = 0; i < factory.equipment.size(); i++) {
-            const auto& equip = factory.equipment[i];
+        for (const auto& holding : factory.equipment) {
+            const Equipment& equip = holding.type;
             std::cout << equip.id
+                << " | Count: " << std::setw(3) << holding.count
                 << " | Output Rate: " << std::setw(3) << equip.output_rate
-                << " | Operational Cost: " << std::setw(6) << equip.operational_cost
-                << " | Price: " << std::setw(6) << equip.price << "\n";
+                << " | Operational Cost: " << std::setw(6) << formatPrice(equip.operational_cost)
+                << " | Price: " << std::setw(6) << formatPrice(equip.price) << "\n";
         }
     }
 }
 
 // Helper function: Handle production of a product.
-static void produceProduct(Factory& player, const std::vector<Commodity>& productCatalog) {
+static void produceProduct(Factory& player, const std::vector<Commodity>& productCatalog,
+                           const ProductionEngine& production) {
     int productId;
     std::cout << "Enter the product ID you want to produce: ";
     std::cin >> productId;
@@ -343,80 +349,43 @@ static void produceProduct(Factory& player, const std::vector<Commodity>& produc
     std::cout << "Enter desired production amount: ";
     std::cin >> requestedAmount;
 
-    // Determine maximum production possible based on available resources.
-    int maxProductionByResources = requestedAmount;
-    for (const auto& req : chosenProduct->recipe) {
-        int resourceId = req.first;
-        int requiredPerUnit = req.second;
-        int available = 0;
-        for (const auto& item : player.inventory) {
-            if (item.first.id == resourceId && item.first.type == CommodityType::Resource) {
-                available = item.second;
-                break;
+    // The engine caps production by ingredients held (resources or, for multi-level
+    // recipes, other products), total capacity and each required equipment type.
+    int producibleAmount = std::min(requestedAmount, production.maxProducible(player, chosenProduct->id));
+    if (producibleAmount <= 0) {
+        // Say which limit applies.
+        if (player.capacity <= 0) {
+            std::cout << "No equipment available for production.\n";
+            return;
+        }
+        for (const auto& req : chosenProduct->requiredEquipment) {
+            if (player.equipmentCount(req.first) < req.second) {
+                std::cout << "This product requires " << req.second << " units of Equipment " << req.first
+                    << " (you own " << player.equipmentCount(req.first) << ").\n";
+                return;
             }
         }
-        int possibleForThisResource = available / requiredPerUnit;
-        if (possibleForThisResource < maxProductionByResources)
-            maxProductionByResources = possibleForThisResource;
-    }
-
-    if (maxProductionByResources <= 0) {
         std::cout << "Insufficient resources for production.\n";
         return;
     }
 
-    // Equipment capacity: sum of output rates of all owned equipment.
-    int equipmentCapacity = 0;
-    float totalOperationalCost = 0.0f;
-    for (const auto& equip : player.equipment) {
-        equipmentCapacity += equip.output_rate;
-        totalOperationalCost += equip.operational_cost;
-    }
-    if (equipmentCapacity <= 0) {
-        std::cout << "No equipment available for production.\n";
-        return;
-    }
-
-    int producibleAmount = std::min({ requestedAmount, maxProductionByResources, equipmentCapacity });
+    Price totalOperationalCost = player.operatingCost;
     if (player.balance < totalOperationalCost) {
         std::cout << "Insufficient balance to cover equipment operating costs.\n";
         return;
     }
 
-    // Deduct required resources based on the product recipe.
-    for (const auto& req : chosenProduct->recipe) {
-        int resourceId = req.first;
-        int totalRequired = producibleAmount * req.second;
-        for (auto& item : player.inventory) {
-            if (item.first.id == resourceId && item.first.type == CommodityType::Resource) {
-                item.second -= totalRequired;
-                break;
-            }
-        }
-    }
+    producibleAmount = production.produce(player, *chosenProduct, producibleAmount);
 
     // Deduct equipment operating cost.
     player.balance -= totalOperationalCost;
 
-    // Add produced product to inventory.
-    bool found = false;
-    for (auto& item : player.inventory) {
-        if (item.first.id == chosenProduct->id && item.first.type == CommodityType::Product) {
-            item.second += producibleAmount;
-            found = true;
-            break;
-        }
-    }
-    if (!found) {
-        Commodity product = *chosenProduct; // Copy product definition.
-        player.inventory.push_back({ product, producibleAmount });
-    }
-
     std::cout << "Produced " << producibleAmount << " units of " << chosenProduct->name << ".\n";
 }
 
 // The player's turn function now takes the entire SimulationWorld.
 void PlayerController::takeTurn(SimulationWorld& world) {
+    METRICS_TIME(MetricPhase::PlayerTurn);
     // Extract components from the world.
     Factory& player = world.playerFactory;
     Market& market = world.market;
@@ -427,7 +396,7 @@ void PlayerController::takeTurn(SimulationWorld& world) {
     bool turnOver = false;
     while (!turnOver) {
         std::cout << "\n--- Player Turn (Factory " << player.id << ") ---\n";
-        std::cout << "Balance: " << player.balance << "\n";
+        std::cout << "Balance: " << formatPrice(player.balance) << "\n";
         std::cout << "Select an action:\n";
         std::cout << "  1. View Product Market\n";
         std::cout << "  2. View Resource Market\n";
@@ -470,10 +439,10 @@ void PlayerController::takeTurn(SimulationWorld& world) {
             purchaseEquipment(player, equipCatalog);
             break;
         case 8:
-            viewProductCatalog(productCatalog);
+            viewProductCatalog(productCatalog, world.productionGraph);
             break;
         case 9:
-            produceProduct(player, productCatalog);
+            produceProduct(player, productCatalog, world.production);
             break;
         case 10:
             turnOver = true;
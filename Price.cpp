@@ -0,0 +1,34 @@
+#include "Price.h"
+#include <cmath>
+
+Price toPrice(double units) {
+    return static_cast<Price>(std::llround(units * PRICE_TICKS_PER_UNIT));
+}
+
+double priceToDouble(Price price) {
+    return static_cast<double>(price) / PRICE_TICKS_PER_UNIT;
+}
+
+std::string formatPrice(Price price) {
+    // Enough decimals to show one tick: 100 ticks per unit -> 2, 8 -> 1 (0.125 shows as 0.1).
+    int decimals = 0;
+    int64_t scale = 1;
+    while (scale < PRICE_TICKS_PER_UNIT) {
+        scale *= 10;
+        decimals++;
+    }
+    bool negative = price < 0;
+    uint64_t magnitude = negative ? 0 - static_cast<uint64_t>(price) : static_cast<uint64_t>(price);
+    uint64_t whole = magnitude / PRICE_TICKS_PER_UNIT;
+    uint64_t fraction = (magnitude % PRICE_TICKS_PER_UNIT) * scale / PRICE_TICKS_PER_UNIT;
+
+    std::string text = negative ? "-" : "";
+    text += std::to_string(whole);
+    if (decimals > 0) {
+        std::string digits = std::to_string(fraction);
+        text += '.';
+        text.append(decimals - digits.size(), '0');
+        text += digits;
+    }
+    return text;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Prices and cash are whole numbers of price ticks. A tick is 1 / PRICE_TICKS_PER_UNIT of
+// a currency unit, and the tick size is fixed at compile time (CMake option
+// MARKET_SIM_PRICE_TICKS_PER_UNIT). Comparisons and sums are exact integer arithmetic,
+// so the results are the same on every compiler and at every optimisation level.
+// Doubles appear only at the edges: UI input and output, and the LP objective.
+#ifndef MARKET_SIM_PRICE_TICKS_PER_UNIT
+#define MARKET_SIM_PRICE_TICKS_PER_UNIT 100
+#endif
+
+using Price = int64_t;
+
+constexpr Price PRICE_TICKS_PER_UNIT = MARKET_SIM_PRICE_TICKS_PER_UNIT;
+static_assert(PRICE_TICKS_PER_UNIT > 0, "MARKET_SIM_PRICE_TICKS_PER_UNIT must be positive");
+
+// Whole currency units as ticks.
+constexpr Price unitsToPrice(int64_t units) { return units * PRICE_TICKS_PER_UNIT; }
+
+// Converts a currency amount (e.g. typed by the player) to the nearest tick.
+Price toPrice(double units);
+
+// Currency amount of a price, for display and for floating-point models such as the LP.
+double priceToDouble(Price price);
+
+// price * numerator / denominator, rounded to the nearest tick (halves away from zero).
+// Used for percentage adjustments such as "5% above the current price". Inline and free of
+// branches (the signs are applied with masks) so the price kernels can use it in flat loops.
+constexpr Price scalePrice(Price price, int64_t numerator, int64_t denominator) {
+    int64_t flip = denominator >> 63;   // -1 if the denominator is negative, else 0.
+    numerator = (numerator ^ flip) - flip;
+    denominator = (denominator ^ flip) - flip;
+    Price product = price * numerator;
+    int64_t sign = product >> 63;
+    Price half = denominator / 2;
+    return (product + ((half ^ sign) - sign)) / denominator;
+}
+
+// Exact decimal text of a price, e.g. "12.34" with 100 ticks per unit.
+std::string formatPrice(Price price);
@@ -0,0 +1,125 @@
+#include "PriceEngine.h"
+#include "Initialization.h"
+#include "Log.h"
+#include "MarketDataFeed.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+    const int MIN_SUPPLY = 100;
+    const int MAX_SUPPLY = 1000;
+    const double STATISTICS_WEIGHT = 0.2;      // Weight of today in the EMA and variance.
+}
+
+int PriceEngine::slot(int commodityId) const {
+    auto it = slotOf.find(commodityId);
+    return it == slotOf.end() ? -1 : it->second;
+}
+
+double PriceEngine::volatility(int slot) const {
+    return std::sqrt(variance[slot]);
+}
+
+void PriceEngine::build(const SimulationWorld& world) {
+    resourceCount = world.resourceCatalog.size();
+    size_t count = resourceCount + world.productCatalog.size();
+    ids.clear();
+    prices.clear();
+    slotOf.clear();
+    for (const auto& res : world.resourceCatalog) {
+        slotOf[res.id] = static_cast<int>(ids.size());
+        ids.push_back(res.id);
+        prices.push_back(res.price);
+    }
+    for (const auto& prod : world.productCatalog) {
+        slotOf[prod.id] = static_cast<int>(ids.size());
+        ids.push_back(prod.id);
+        prices.push_back(prod.price);
+    }
+    nextPrices.assign(count, 0);
+    demand.assign(count, 0);
+    supply.assign(count, 0);
+    tradedVolume.assign(count, 0);
+    tradedNotional.assign(count, 0);
+    denominators.assign(count, 0);
+    ema.assign(prices.begin(), prices.end());
+    variance.assign(count, 0.0);
+    ratio.assign(count, 0.0);
+}
+
+void PriceEngine::gather(SimulationWorld& world) {
+    const Market& market = world.market;
+    std::uniform_int_distribution<int> supplyDist(MIN_SUPPLY, MAX_SUPPLY);
+    for (size_t i = 0; i < ids.size(); i++) {
+        demand[i] = market.restingAmount(ids[i], OrderType::BUY);
+        supply[i] = i < resourceCount ? supplyDist(world.rng) : market.restingAmount(ids[i], OrderType::SELL);
+    }
+    std::fill(tradedVolume.begin(), tradedVolume.end(), 0);
+    std::fill(tradedNotional.begin(), tradedNotional.end(), 0);
+    // The market keeps the day's trades until the price update, so each is seen once.
+    for (const Trade& trade : market.trades) {
+        int s = slot(trade.productId);
+        if (s < 0)
+            continue;
+        tradedVolume[s] += trade.amount;
+        tradedNotional[s] += trade.price * trade.amount;
+    }
+}
+
+void PriceEngine::computePrices() {
+    computeNextPrices(resourceCount, ids.size(), prices, demand, supply, tradedVolume, tradedNotional,
+                      denominators, nextPrices);
+}
+
+void PriceEngine::computeStatistics() {
+    const size_t count = ids.size();
+    for (size_t i = 0; i < count; i++) {
+        double previous = static_cast<double>(prices[i]);
+        double next = static_cast<double>(nextPrices[i]);
+        double change = next / previous - 1.0;
+        ema[i] += STATISTICS_WEIGHT * (next - ema[i]);
+        variance[i] += STATISTICS_WEIGHT * (change * change - variance[i]);
+        double available = static_cast<double>(supply[i]);
+        ratio[i] = available > 0.0 ? static_cast<double>(demand[i]) / available : 0.0;
+    }
+    prices.swap(nextPrices);
+}
+
+void PriceEngine::publish(SimulationWorld& world) {
+    for (size_t i = 0; i < ids.size(); i++) {
+        bool isResource = i < resourceCount;
+        Commodity& item = isResource ? world.resourceCatalog[i] : world.productCatalog[i - resourceCount];
+        Price newPrice = prices[i];
+        if (isResource) {
+            simLog() << "Updating " << item.name << " (ID " << item.id
+                << "): Demand = " << demand[i]
+                << ", Supply = " << supply[i]
+                << ", New Price = " << formatPrice(newPrice) << "\n";
+        }
+        else if (newPrice != item.price) {
+            simLog() << "Updating " << item.name << " (ID " << item.id
+                << "): Traded = " << tradedVolume[i]
+                << ", Bid/Ask = " << demand[i] << "/" << supply[i]
+                << ", New Price = " << formatPrice(newPrice) << "\n";
+        }
+        item.price = newPrice;
+        world.productionGraph.setPrice(item.id, newPrice);
+        if (world.market.feed)
+            world.market.feed->publishReferencePrice(item.id, newPrice);
+
+        // List the day's supply of each resource; ownerId 0 is the market itself.
+        if (isResource)
+            world.market.placeSellOrder(item.id, static_cast<int>(supply[i]), newPrice, 0);
+    }
+}
+
+void PriceEngine::update(SimulationWorld& world) {
+    if (resourceCount != world.resourceCatalog.size() ||
+        ids.size() != world.resourceCatalog.size() + world.productCatalog.size())
+        build(world);
+    gather(world);
+    computePrices();
+    computeStatistics();
+    publish(world);
+}
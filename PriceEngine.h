@@ -0,0 +1,102 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "Price.h"
+
+struct SimulationWorld;
+
+// Daily price dynamics for every commodity, kept in structure-of-arrays form: one array
+// per quantity, indexed by slot (resources first, in catalog order, then products).
+// Each update gathers the day's inputs into the arrays, runs the price and statistics
+// kernels as flat loops over them, and writes the results back to the catalogs.
+//
+// Resources follow demand against a random daily supply, as before:
+//   price * (1 + (demand / supply - 1) / 10)
+// Products follow trading: the day's VWAP (or the current price if nothing traded),
+// shifted by the resting book imbalance (bid - ask) / (bid + ask) / 20, and moved halfway
+// there. Demand comes from the Market's incrementally maintained resting totals and the
+// VWAP from the day's trades, so no pass over the order book is needed.
+class PriceEngine {
+public:
+    // Runs one daily update on 'world': new prices for all commodities, the production
+    // graph and market data feed are told about them, and fresh resource supply is listed.
+    // (Re)builds the slots whenever the catalogs have changed size.
+    void update(SimulationWorld& world);
+
+    // Slot of a commodity, or -1 if the engine has not seen it.
+    int slot(int commodityId) const;
+
+    size_t size() const { return ids.size(); }
+    Price price(int slot) const { return prices[slot]; }
+    double averagePrice(int slot) const { return ema[slot]; }    // Exponential moving average.
+    double volatility(int slot) const;                           // Of daily returns (EWMA).
+    double demandRatio(int slot) const { return ratio[slot]; }   // Demand / supply (resources),
+                                                                 // bid / ask quantity (products).
+
+    // The price kernel: next[i] for slots 0 .. count - 1, of which the first 'resources'
+    // are resources. 'denominators' is scratch space of the same size. A template so
+    // fixed-size callers (FixedWorld) get the same model over std::arrays.
+    template <typename Prices, typename Amounts>
+    static void computeNextPrices(size_t resources, size_t count, const Prices& prices,
+                                  const Amounts& demand, const Amounts& supply,
+                                  const Amounts& tradedVolume, const Amounts& tradedNotional,
+                                  Amounts& denominators, Prices& next);
+
+private:
+    static constexpr int64_t RESOURCE_SENSITIVITY = 10;   // alpha = 1 / 10
+    static constexpr int64_t IMBALANCE_SENSITIVITY = 20;  // Full imbalance moves a product 5%.
+    static constexpr Price MIN_PRICE = unitsToPrice(1);
+
+    void build(const SimulationWorld& world);
+    void gather(SimulationWorld& world);
+    void computePrices();
+    void computeStatistics();
+    void publish(SimulationWorld& world);
+
+    size_t resourceCount = 0;
+    std::unordered_map<int, int> slotOf;
+
+    std::vector<int> ids;
+    std::vector<Price> prices;
+    std::vector<Price> nextPrices;
+    std::vector<int64_t> demand;         // Resting BUY quantity.
+    std::vector<int64_t> supply;         // Resources: today's random supply; products: resting SELL quantity.
+    std::vector<int64_t> tradedVolume;   // Today's trades.
+    std::vector<int64_t> tradedNotional; // Sum of price * amount, in ticks.
+    std::vector<int64_t> denominators;   // Scratch for computeNextPrices.
+    std::vector<double> ema;
+    std::vector<double> variance;
+    std::vector<double> ratio;
+};
+
+template <typename Prices, typename Amounts>
+void PriceEngine::computeNextPrices(size_t resources, size_t count, const Prices& prices,
+                                    const Amounts& demand, const Amounts& supply,
+                                    const Amounts& tradedVolume, const Amounts& tradedNotional,
+                                    Amounts& denominators, Prices& next) {
+    // Both kinds of slot move a base price by scalePrice(base, demand - supply, denominator):
+    // resources from their price, in proportion to supply; products from the day's VWAP (or
+    // their price if nothing traded), in proportion to book depth. An empty book has
+    // demand - supply = 0, so clamping its depth to 1 leaves the base unchanged. With the
+    // bases and denominators set up first, the loops below have no branches.
+    for (size_t i = 0; i < resources; i++) {
+        next[i] = prices[i];
+        denominators[i] = RESOURCE_SENSITIVITY * supply[i];
+    }
+    for (size_t i = resources; i < count; i++) {
+        int64_t volume = std::max<int64_t>(tradedVolume[i], 1);
+        Price vwap = (tradedNotional[i] + volume / 2) / volume;
+        next[i] = tradedVolume[i] > 0 ? vwap : prices[i];
+        denominators[i] = IMBALANCE_SENSITIVITY * std::max<int64_t>(demand[i] + supply[i], 1);
+    }
+    for (size_t i = 0; i < count; i++)
+        next[i] += scalePrice(next[i], demand[i] - supply[i], denominators[i]);
+    // Products only go halfway towards that target.
+    for (size_t i = resources; i < count; i++)
+        next[i] = prices[i] + scalePrice(next[i] - prices[i], 1, 2);
+    for (size_t i = 0; i < count; i++)
+        next[i] = std::max(next[i], MIN_PRICE);
+}
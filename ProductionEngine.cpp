@@ -0,0 +1,153 @@
+#include "ProductionEngine.h"
+#include <algorithm>
+#include <cassert>
+#include <climits>
+
+void ProductionEngine::build(const std::vector<Commodity>& resourceCatalog,
+                             const std::vector<Commodity>& productCatalog) {
+    slotOf.clear();
+    productIndex.clear();
+    recipeStart.assign(1, 0);
+    ingredientSlot.clear();
+    ingredientPerUnit.clear();
+    equipmentStart.assign(1, 0);
+    equipmentId.clear();
+    equipmentNeeded.clear();
+
+    for (const auto& res : resourceCatalog)
+        slotOf[res.id] = static_cast<int>(slotOf.size());
+    for (const auto& prod : productCatalog)
+        slotOf[prod.id] = static_cast<int>(slotOf.size());
+
+    for (const auto& prod : productCatalog) {
+        productIndex[prod.id] = static_cast<int>(recipeStart.size()) - 1;
+        // An ingredient listed twice becomes one entry needing the sum, so unitsFor and
+        // produce never count the same inventory against it twice.
+        int rowBegin = recipeStart.back();
+        for (const auto& req : prod.recipe) {
+            auto it = slotOf.find(req.first);
+            int slot = it == slotOf.end() ? -1 : it->second;
+            int perUnit = std::max(1, req.second);
+            auto begin = ingredientSlot.begin() + rowBegin;
+            auto found = std::find(begin, ingredientSlot.end(), slot);
+            if (found != ingredientSlot.end()) {
+                ingredientPerUnit[found - ingredientSlot.begin()] += perUnit;
+                continue;
+            }
+            ingredientSlot.push_back(slot);
+            ingredientPerUnit.push_back(perUnit);
+        }
+        recipeStart.push_back(static_cast<int>(ingredientSlot.size()));
+        for (const auto& req : prod.requiredEquipment) {
+            equipmentId.push_back(req.first);
+            equipmentNeeded.push_back(req.second);
+        }
+        equipmentStart.push_back(static_cast<int>(equipmentId.size()));
+    }
+}
+
+void ProductionEngine::gatherHoldings(const Factory& factory, std::vector<int>& held) const {
+    held.assign(slotOf.size() + 1, 0);
+    int* slots = held.data() + 1;   // slots[-1] stays 0 for unknown ingredients.
+    for (const auto& item : factory.inventory) {
+        auto it = slotOf.find(item.first.id);
+        if (it != slotOf.end())
+            slots[it->second] += item.second;
+    }
+}
+
+int ProductionEngine::equipmentLimit(const Factory& factory, int product) const {
+    int limit = factory.capacity;
+    for (int k = equipmentStart[product]; k < equipmentStart[product + 1]; k++) {
+        if (factory.equipmentCount(equipmentId[k]) < equipmentNeeded[k])
+            return 0;
+        limit = std::min(limit, factory.equipmentCapacity(equipmentId[k]));
+    }
+    return std::max(limit, 0);
+}
+
+int ProductionEngine::unitsFor(const std::vector<int>& held, int product) const {
+    int begin = recipeStart[product];
+    int end = recipeStart[product + 1];
+    if (begin == end)
+        return 0;   // No recipe: not manufacturable.
+    const int* slots = held.data() + 1;
+    int units = INT_MAX;
+    for (int k = begin; k < end; k++)
+        units = std::min(units, slots[ingredientSlot[k]] / ingredientPerUnit[k]);
+    return std::max(units, 0);
+}
+
+void ProductionEngine::maxProducible(const Factory& factory, std::vector<int>& units) const {
+    std::vector<int> held;
+    gatherHoldings(factory, held);
+    const int* slots = held.data() + 1;
+    // Units each ingredient entry allows, for all products at once, then the minimum per row.
+    std::vector<int> allowed(ingredientSlot.size());
+    for (size_t k = 0; k < ingredientSlot.size(); k++)
+        allowed[k] = slots[ingredientSlot[k]] / ingredientPerUnit[k];
+    int products = static_cast<int>(recipeStart.size()) - 1;
+    units.resize(products);
+    for (int p = 0; p < products; p++) {
+        int begin = recipeStart[p];
+        int end = recipeStart[p + 1];
+        int limit = begin == end ? 0 : *std::min_element(allowed.begin() + begin, allowed.begin() + end);
+        units[p] = std::max(limit, 0);
+    }
+    for (int p = 0; p < products; p++) {
+        if (units[p] > 0)
+            units[p] = std::min(units[p], equipmentLimit(factory, p));
+    }
+}
+
+int ProductionEngine::maxProducible(const Factory& factory, int productId) const {
+    auto it = productIndex.find(productId);
+    if (it == productIndex.end())
+        return 0;
+    std::vector<int> held;
+    gatherHoldings(factory, held);
+    int units = unitsFor(held, it->second);
+    return units > 0 ? std::min(units, equipmentLimit(factory, it->second)) : 0;
+}
+
+int ProductionEngine::produce(Factory& factory, const Commodity& product, int quantity) const {
+    auto it = productIndex.find(product.id);
+    if (it == productIndex.end() || quantity <= 0)
+        return 0;
+    int row = it->second;
+    quantity = std::min(quantity, maxProducible(factory, product.id));
+    if (quantity <= 0)
+        return 0;
+
+    // One pass: every inventory entry is checked against the recipe row, and the output
+    // entry is found on the way. Several entries may hold the same commodity; each gives
+    // what it has until the ingredient is covered.
+    int begin = recipeStart[row];
+    int end = recipeStart[row + 1];
+    std::vector<int> remaining(end - begin);
+    for (int k = begin; k < end; k++)
+        remaining[k - begin] = quantity * ingredientPerUnit[k];
+    std::vector<std::pair<Commodity, int>>& inventory = factory.inventory.write();
+    std::pair<Commodity, int>* output = nullptr;
+    for (auto& item : inventory) {
+        if (!output && item.first.id == product.id && item.first.type == CommodityType::Product)
+            output = &item;
+        auto slot = slotOf.find(item.first.id);
+        if (slot == slotOf.end())
+            continue;
+        for (int k = begin; k < end; k++) {
+            if (ingredientSlot[k] != slot->second || remaining[k - begin] == 0 || item.second <= 0)
+                continue;
+            int taken = std::min(remaining[k - begin], item.second);
+            item.second -= taken;
+            remaining[k - begin] -= taken;
+        }
+    }
+    // maxProducible checked the holdings, so every ingredient must have been covered.
+    assert(std::all_of(remaining.begin(), remaining.end(), [](int left) { return left == 0; }));
+    if (output)
+        output->second += quantity;
+    else
+        inventory.push_back({ product, quantity });
+    return quantity;
+}
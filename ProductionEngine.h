@@ -0,0 +1,46 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include "Commodity.h"
+#include "Factory.h"
+
+// Recipe-driven production shared by every controller. The catalog's recipes and
+// equipment requirements are compiled into flat arrays (one row per product, in catalog
+// order), so evaluating every product for a factory is one pass over its inventory
+// followed by straight loops over the arrays.
+class ProductionEngine {
+public:
+    // Compiles the recipes of 'productCatalog'. Call again whenever the catalogs change.
+    void build(const std::vector<Commodity>& resourceCatalog, const std::vector<Commodity>& productCatalog);
+
+    // Units of each product (catalog order) 'factory' could make right now, each product
+    // considered on its own: the minimum over ingredients of held / needed per unit, capped
+    // by the factory's total capacity and the capacity of each required equipment type.
+    // Products without a recipe, or whose required equipment is not owned, get 0.
+    void maxProducible(const Factory& factory, std::vector<int>& units) const;
+
+    // The same for one product; 0 if the engine does not know it.
+    int maxProducible(const Factory& factory, int productId) const;
+
+    // Makes up to 'quantity' units of 'product' (never more than maxProducible): consumes
+    // the ingredients and adds the output in a single pass over the inventory. Operating
+    // costs are the caller's business. Returns the number of units made.
+    int produce(Factory& factory, const Commodity& product, int quantity) const;
+
+private:
+    // Held quantity of every catalog commodity, indexed by slot.
+    void gatherHoldings(const Factory& factory, std::vector<int>& held) const;
+    int equipmentLimit(const Factory& factory, int product) const;
+    int unitsFor(const std::vector<int>& held, int product) const;
+
+    std::unordered_map<int, int> slotOf;       // Commodity id -> slot (resources, then products).
+    std::unordered_map<int, int> productIndex; // Product id -> row.
+    // Row p's ingredients are entries recipeStart[p] .. recipeStart[p + 1] - 1.
+    std::vector<int> recipeStart;
+    std::vector<int> ingredientSlot;           // -1 for ids outside the catalogs.
+    std::vector<int> ingredientPerUnit;
+    // Row p's equipment requirements, as (equipment id, units needed).
+    std::vector<int> equipmentStart;
+    std::vector<int> equipmentId;
+    std::vector<int> equipmentNeeded;
+};
@@ -0,0 +1,145 @@
+#include "ProductionGraph.h"
+#include "Log.h"
+
+bool ProductionGraph::build(const std::vector<Commodity>& resourceCatalog,
+                            const std::vector<Commodity>& productCatalog,
+                            const std::vector<Equipment>& equipmentCatalog) {
+    nodes.clear();
+    indexOf.clear();
+    order.clear();
+
+    std::unordered_map<int, const Equipment*> equipmentById;
+    for (const auto& equip : equipmentCatalog)
+        equipmentById[equip.id] = &equip;
+
+    auto addNode = [&](const Commodity& commodity, bool isProduct) {
+        Node node;
+        node.id = commodity.id;
+        node.isProduct = isProduct;
+        node.price = commodity.price;
+        node.operatingCostPerUnit = 0;
+        node.rawCost = isProduct ? 0 : commodity.price;
+        node.marginal = node.rawCost;
+        node.dirty = isProduct;
+        indexOf[commodity.id] = static_cast<int>(nodes.size());
+        nodes.push_back(node);
+    };
+    for (const auto& res : resourceCatalog)
+        addNode(res, false);
+    for (const auto& prod : productCatalog)
+        addNode(prod, true);
+
+    // Wire up recipe edges and per-unit operating costs.
+    for (const auto& prod : productCatalog) {
+        Node& node = nodes[indexOf[prod.id]];
+        for (const auto& req : prod.recipe) {
+            auto it = indexOf.find(req.first);
+            if (it == indexOf.end()) {
+                simLog() << "ProductionGraph: product " << prod.id << " uses unknown commodity " << req.first << "\n";
+                nodes.clear();
+                indexOf.clear();
+                return false;
+            }
+            node.inputs.push_back({ it->second, req.second });
+            nodes[it->second].consumers.push_back(indexOf[prod.id]);
+        }
+        for (const auto& req : prod.requiredEquipment) {
+            auto it = equipmentById.find(req.first);
+            if (it != equipmentById.end() && it->second->output_rate > 0)
+                node.operatingCostPerUnit += scalePrice(it->second->operational_cost, 1, it->second->output_rate);
+        }
+    }
+
+    // Kahn's algorithm over products: a product is ready once all its product inputs are.
+    std::vector<int> pendingInputs(nodes.size(), 0);
+    std::vector<int> ready;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (!nodes[i].isProduct)
+            continue;
+        for (const auto& input : nodes[i].inputs) {
+            if (nodes[input.first].isProduct)
+                pendingInputs[i]++;
+        }
+        if (pendingInputs[i] == 0)
+            ready.push_back(static_cast<int>(i));
+    }
+    for (size_t next = 0; next < ready.size(); next++) {
+        int current = ready[next];
+        order.push_back(nodes[current].id);
+        for (int consumer : nodes[current].consumers) {
+            if (--pendingInputs[consumer] == 0)
+                ready.push_back(consumer);
+        }
+    }
+    if (order.size() != productCatalog.size()) {
+        simLog() << "ProductionGraph: product recipes contain a cycle\n";
+        nodes.clear();
+        indexOf.clear();
+        order.clear();
+        return false;
+    }
+    return true;
+}
+
+bool ProductionGraph::isProduct(int commodityId) const {
+    auto it = indexOf.find(commodityId);
+    return it != indexOf.end() && nodes[it->second].isProduct;
+}
+
+void ProductionGraph::setPrice(int commodityId, Price price) {
+    auto it = indexOf.find(commodityId);
+    if (it == indexOf.end())
+        return;
+    Node& node = nodes[it->second];
+    if (node.price == price)
+        return;
+    node.price = price;
+    if (node.isProduct)
+        return;
+    node.rawCost = price;
+    node.marginal = price;
+    for (int consumer : node.consumers)
+        markDirty(consumer);
+}
+
+void ProductionGraph::markDirty(int node) {
+    // A dirty node's consumers are already dirty, so the walk stops there.
+    if (nodes[node].dirty)
+        return;
+    nodes[node].dirty = true;
+    for (int consumer : nodes[node].consumers)
+        markDirty(consumer);
+}
+
+void ProductionGraph::refresh(int node) {
+    Node& n = nodes[node];
+    if (!n.dirty)
+        return;
+    Price raw = 0;
+    Price marginal = n.operatingCostPerUnit;
+    for (const auto& input : n.inputs) {
+        refresh(input.first);
+        raw += nodes[input.first].rawCost * input.second;
+        marginal += nodes[input.first].marginal * input.second;
+    }
+    n.rawCost = raw;
+    n.marginal = marginal;
+    n.dirty = false;
+    recomputations++;
+}
+
+Price ProductionGraph::rawMaterialCost(int productId) {
+    auto it = indexOf.find(productId);
+    if (it == indexOf.end())
+        return 0;
+    refresh(it->second);
+    return nodes[it->second].rawCost;
+}
+
+Price ProductionGraph::marginalCost(int productId) {
+    auto it = indexOf.find(productId);
+    if (it == indexOf.end())
+        return 0;
+    refresh(it->second);
+    return nodes[it->second].marginal;
+}
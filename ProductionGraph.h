@@ -0,0 +1,62 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include "Commodity.h"
+
+// Bill-of-materials graph over the catalogs. Products may be made from resources and
+// from other products; the graph is built once, ordered topologically (ingredients
+// before the products that use them), and caches per-product costs.
+//
+// Costs are memoised per product and invalidated only downstream of a price change:
+// setPrice() on a resource marks the products that (transitively) use it as stale, and
+// the next query recomputes just those nodes.
+class ProductionGraph {
+public:
+    // Builds the graph. Returns false (and leaves the graph empty) if a recipe refers to
+    // an unknown commodity or the recipes contain a cycle.
+    bool build(const std::vector<Commodity>& resourceCatalog,
+               const std::vector<Commodity>& productCatalog,
+               const std::vector<Equipment>& equipmentCatalog);
+
+    // Product ids, every product after all products in its recipe.
+    const std::vector<int>& topologicalOrder() const { return order; }
+
+    bool contains(int commodityId) const { return indexOf.count(commodityId) != 0; }
+    bool isProduct(int commodityId) const;
+
+    // Records a new market price for a commodity. Only resource prices feed the cost
+    // rollup, so product price changes invalidate nothing.
+    void setPrice(int commodityId, Price price);
+
+    // Cost of the resources consumed, through every recipe level, to make one unit.
+    Price rawMaterialCost(int productId);
+
+    // Raw material cost plus the equipment operating cost per unit at every level
+    // (operational_cost / output_rate for each required equipment type).
+    Price marginalCost(int productId);
+
+    // Number of cost recomputations performed so far (for instrumentation and tests of
+    // the incremental behaviour).
+    size_t recomputeCount() const { return recomputations; }
+
+private:
+    struct Node {
+        int id;
+        bool isProduct;
+        Price price;
+        Price operatingCostPerUnit;                // Products only; rounded to the nearest tick.
+        std::vector<std::pair<int, int>> inputs;   // (node index, quantity per unit).
+        std::vector<int> consumers;                // Node indices of products using this node.
+        Price rawCost;
+        Price marginal;
+        bool dirty;
+    };
+
+    void markDirty(int node);
+    void refresh(int node);
+
+    std::vector<Node> nodes;
+    std::unordered_map<int, int> indexOf;
+    std::vector<int> order;
+    size_t recomputations = 0;
+};
@@ -1,4 +1,6 @@
 #pragma once
 #include "Initialization.h"
 
-void updateResourcePrices(SimulationWorld& world);
+// End-of-day price update for resources and products (world.priceEngine), followed by
+// the day's resource supply.
+void updateMarketPrices(SimulationWorld& world);
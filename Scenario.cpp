@@ -0,0 +1,352 @@
+#include "Scenario.h"
+#include "Log.h"
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+    const int MAX_FIELDS = 6;
+
+    // A field is a slice of the input text; nothing is copied while parsing.
+    struct Field {
+        const char* begin;
+        const char* end;
+
+        bool is(const char* word) const {
+            size_t length = std::strlen(word);
+            return static_cast<size_t>(end - begin) == length && std::memcmp(begin, word, length) == 0;
+        }
+    };
+
+    struct CommodityRef {
+        bool isProduct;
+        int index;      // Into resourceCatalog or productCatalog.
+    };
+
+    // Parses a decimal amount such as "12", "-3.5" or "0.125" into ticks, rounding to the
+    // nearest tick. Digits past the ninth decimal are ignored.
+    bool parseAmount(const Field& field, Price& price) {
+        const char* p = field.begin;
+        bool negative = p < field.end && *p == '-';
+        if (negative)
+            p++;
+        const int64_t maxWhole = std::numeric_limits<int64_t>::max() / PRICE_TICKS_PER_UNIT / 10;
+        int64_t whole = 0;
+        bool digits = false;
+        for (; p < field.end && *p >= '0' && *p <= '9'; p++) {
+            whole = whole * 10 + (*p - '0');
+            if (whole > maxWhole)
+                return false;
+            digits = true;
+        }
+        int64_t fraction = 0;
+        int64_t scale = 1;
+        if (p < field.end && *p == '.') {
+            for (p++; p < field.end && *p >= '0' && *p <= '9'; p++) {
+                if (scale < 1000000000) {
+                    fraction = fraction * 10 + (*p - '0');
+                    scale *= 10;
+                }
+                digits = true;
+            }
+        }
+        if (p != field.end || !digits)
+            return false;
+        price = whole * PRICE_TICKS_PER_UNIT + scalePrice(fraction, PRICE_TICKS_PER_UNIT, scale);
+        if (negative)
+            price = -price;
+        return true;
+    }
+
+    class ScenarioParser {
+    public:
+        ScenarioParser(SimulationWorld& world, std::string& error) : world(world), error(error), line(0) {}
+
+        bool parse(const char* text, size_t length);
+
+    private:
+        bool fail(const std::string& message) {
+            error = "line " + std::to_string(line) + ": " + message;
+            return false;
+        }
+
+        bool integer(const Field& field, int& value, const char* what) {
+            auto result = std::from_chars(field.begin, field.end, value);
+            if (result.ec != std::errc() || result.ptr != field.end)
+                return fail(std::string("invalid ") + what);
+            return true;
+        }
+
+        bool positive(const Field& field, int& value, const char* what) {
+            if (!integer(field, value, what))
+                return false;
+            if (value <= 0)
+                return fail(std::string(what) + " must be positive");
+            return true;
+        }
+
+        bool amount(const Field& field, Price& value, const char* what) {
+            if (!parseAmount(field, value))
+                return fail(std::string("invalid ") + what);
+            return true;
+        }
+
+        bool record(const Field* fields, int count);
+        bool commodity(const Field* fields, bool isProduct);
+        bool equipment(const Field* fields);
+        bool productLink(const Field* fields, bool isRecipe);
+        bool factory(const Field* fields, bool isPlayer);
+        bool factoryItem(const Field* fields, bool isStock);
+
+        Factory* findFactory(int id);
+
+        SimulationWorld& world;
+        std::string& error;
+        int line;
+        bool hasPlayer = false;
+        std::unordered_map<int, CommodityRef> commodities;
+        std::unordered_map<int, int> equipmentIndex;
+        std::unordered_map<int, int> factoryIndex;    // -1 = the player's factory.
+    };
+
+    bool ScenarioParser::parse(const char* text, size_t length) {
+        const char* end = text + length;
+        const char* cursor = text;
+        Field fields[MAX_FIELDS + 1];
+        while (cursor < end) {
+            line++;
+            const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+            if (!lineEnd)
+                lineEnd = end;
+            const char* next = lineEnd < end ? lineEnd + 1 : end;
+            if (lineEnd > cursor && lineEnd[-1] == '\r')
+                lineEnd--;
+            while (cursor < lineEnd && (*cursor == ' ' || *cursor == '\t'))
+                cursor++;
+            if (cursor == lineEnd || *cursor == '#') {
+                cursor = next;
+                continue;
+            }
+
+            int count = 0;
+            const char* fieldStart = cursor;
+            while (true) {
+                const char* comma = static_cast<const char*>(std::memchr(fieldStart, ',', lineEnd - fieldStart));
+                const char* fieldEnd = comma ? comma : lineEnd;
+                if (count == MAX_FIELDS + 1)
+                    return fail("too many fields");
+                Field& field = fields[count++];
+                field.begin = fieldStart;
+                field.end = fieldEnd;
+                while (field.begin < field.end && (*field.begin == ' ' || *field.begin == '\t'))
+                    field.begin++;
+                while (field.end > field.begin && (field.end[-1] == ' ' || field.end[-1] == '\t'))
+                    field.end--;
+                if (!comma)
+                    break;
+                fieldStart = comma + 1;
+            }
+            if (!record(fields, count))
+                return false;
+            cursor = next;
+        }
+        return true;
+    }
+
+    bool ScenarioParser::record(const Field* fields, int count) {
+        struct RecordType {
+            const char* name;
+            int fields;
+        };
+        static const RecordType types[] = {
+            { "resource", 4 }, { "product", 4 }, { "equipment", 5 }, { "recipe", 4 }, { "requires", 4 },
+            { "player", 3 }, { "factory", 3 }, { "stock", 4 }, { "owns", 4 },
+        };
+        for (const RecordType& type : types) {
+            if (!fields[0].is(type.name))
+                continue;
+            if (count != type.fields)
+                return fail(std::string(type.name) + " records have " + std::to_string(type.fields) + " fields");
+            break;
+        }
+        if (fields[0].is("resource"))
+            return commodity(fields, false);
+        if (fields[0].is("product"))
+            return commodity(fields, true);
+        if (fields[0].is("equipment"))
+            return equipment(fields);
+        if (fields[0].is("recipe"))
+            return productLink(fields, true);
+        if (fields[0].is("requires"))
+            return productLink(fields, false);
+        if (fields[0].is("player"))
+            return factory(fields, true);
+        if (fields[0].is("factory"))
+            return factory(fields, false);
+        if (fields[0].is("stock"))
+            return factoryItem(fields, true);
+        if (fields[0].is("owns"))
+            return factoryItem(fields, false);
+        return fail("unknown record type '" + std::string(fields[0].begin, fields[0].end) + "'");
+    }
+
+    bool ScenarioParser::commodity(const Field* fields, bool isProduct) {
+        Commodity item;
+        if (!integer(fields[1], item.id, "commodity id") || !amount(fields[3], item.price, "price"))
+            return false;
+        if (commodities.count(item.id))
+            return fail("duplicate commodity id " + std::to_string(item.id));
+        if (item.price <= 0)
+            return fail("price must be positive");
+        item.name.assign(fields[2].begin, fields[2].end);
+        item.type = isProduct ? CommodityType::Product : CommodityType::Resource;
+        std::vector<Commodity>& catalog = isProduct ? world.productCatalog : world.resourceCatalog;
+        commodities[item.id] = { isProduct, static_cast<int>(catalog.size()) };
+        catalog.push_back(std::move(item));
+        return true;
+    }
+
+    bool ScenarioParser::equipment(const Field* fields) {
+        Equipment equip;
+        if (!integer(fields[1], equip.id, "equipment id") || !amount(fields[2], equip.price, "price") ||
+            !positive(fields[3], equip.output_rate, "output rate") ||
+            !amount(fields[4], equip.operational_cost, "operating cost"))
+            return false;
+        if (equipmentIndex.count(equip.id))
+            return fail("duplicate equipment id " + std::to_string(equip.id));
+        if (equip.price < 0 || equip.operational_cost < 0)
+            return fail("equipment costs cannot be negative");
+        equipmentIndex[equip.id] = static_cast<int>(world.equipmentCatalog.size());
+        world.equipmentCatalog.push_back(equip);
+        return true;
+    }
+
+    bool ScenarioParser::productLink(const Field* fields, bool isRecipe) {
+        int productId = 0, otherId = 0, quantity = 0;
+        if (!integer(fields[1], productId, "product id") || !integer(fields[2], otherId, "id") ||
+            !positive(fields[3], quantity, "quantity"))
+            return false;
+        auto product = commodities.find(productId);
+        if (product == commodities.end() || !product->second.isProduct)
+            return fail("unknown product " + std::to_string(productId));
+        bool known = isRecipe ? commodities.count(otherId) != 0 : equipmentIndex.count(otherId) != 0;
+        if (!known)
+            return fail(std::string(isRecipe ? "unknown commodity " : "unknown equipment ") + std::to_string(otherId));
+        Commodity& prod = world.productCatalog[product->second.index];
+        auto& links = isRecipe ? prod.recipe : prod.requiredEquipment;
+        for (const auto& link : links) {
+            if (link.first == otherId)
+                return fail(std::string(isRecipe ? "duplicate recipe input " : "duplicate required equipment ") +
+                            std::to_string(otherId) + " for product " + std::to_string(productId));
+        }
+        links.push_back({ otherId, quantity });
+        return true;
+    }
+
+    bool ScenarioParser::factory(const Field* fields, bool isPlayer) {
+        int id = 0;
+        Price balance = 0;
+        if (!integer(fields[1], id, "factory id") || !amount(fields[2], balance, "balance"))
+            return false;
+        // Owner id 0 is the market's own, and negative ones belong to the outside traders.
+        if (id <= 0)
+            return fail("factory ids must be positive");
+        if (factoryIndex.count(id))
+            return fail("duplicate factory id " + std::to_string(id));
+        if (isPlayer && hasPlayer)
+            return fail("more than one player record");
+        Factory* target;
+        if (isPlayer) {
+            hasPlayer = true;
+            factoryIndex[id] = -1;
+            target = &world.playerFactory;
+        }
+        else {
+            factoryIndex[id] = static_cast<int>(world.aiFactories.size());
+            world.aiFactories.emplace_back();
+            target = &world.aiFactories.back();
+        }
+        target->id = id;
+        target->balance = balance;
+        return true;
+    }
+
+    Factory* ScenarioParser::findFactory(int id) {
+        auto found = factoryIndex.find(id);
+        if (found == factoryIndex.end())
+            return nullptr;
+        return found->second < 0 ? &world.playerFactory : &world.aiFactories[found->second];
+    }
+
+    bool ScenarioParser::factoryItem(const Field* fields, bool isStock) {
+        int factoryId = 0, itemId = 0, quantity = 0;
+        if (!integer(fields[1], factoryId, "factory id") || !integer(fields[2], itemId, "id") ||
+            !positive(fields[3], quantity, "quantity"))
+            return false;
+        Factory* target = findFactory(factoryId);
+        if (!target)
+            return fail("unknown factory " + std::to_string(factoryId));
+        if (isStock) {
+            auto item = commodities.find(itemId);
+            if (item == commodities.end())
+                return fail("unknown commodity " + std::to_string(itemId));
+            const std::vector<Commodity>& catalog = item->second.isProduct ? world.productCatalog : world.resourceCatalog;
+            target->inventory.write().push_back({ catalog[item->second.index], quantity });
+        }
+        else {
+            auto equip = equipmentIndex.find(itemId);
+            if (equip == equipmentIndex.end())
+                return fail("unknown equipment " + std::to_string(itemId));
+            target->addEquipment(world.equipmentCatalog[equip->second], quantity);
+        }
+        return true;
+    }
+}
+
+bool parseScenario(const char* text, size_t length, unsigned int seed, SimulationWorld& world,
+                   std::string& error) {
+    // Without a player record the player starts with nothing.
+    world.playerFactory.id = 1;
+    world.playerFactory.balance = 0;
+
+    ScenarioParser parser(world, error);
+    if (!parser.parse(text, length))
+        return false;
+    if (!world.productionGraph.build(world.resourceCatalog, world.productCatalog, world.equipmentCatalog)) {
+        error = "the product recipes contain a cycle";
+        return false;
+    }
+    world.production.build(world.resourceCatalog, world.productCatalog);
+    world.rng.seed(seed);
+
+    simLog() << "Scenario loaded with:\n"
+        << world.resourceCatalog.size() << " resources,\n"
+        << world.productCatalog.size() << " products,\n"
+        << world.equipmentCatalog.size() << " equipment types,\n"
+        << world.aiFactories.size() << " AI factories.\n";
+    return true;
+}
+
+bool readScenarioFile(const std::string& path, std::string& text) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+    std::streamsize size = file.tellg();
+    if (size < 0)
+        return false;
+    text.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    return static_cast<bool>(file.read(&text[0], size)) || size == 0;
+}
+
+bool loadScenario(const std::string& path, unsigned int seed, SimulationWorld& world, std::string& error) {
+    std::string text;
+    if (!readScenarioFile(path, text)) {
+        error = "cannot read " + path;
+        return false;
+    }
+    return parseScenario(text.data(), text.size(), seed, world, error);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include "Initialization.h"
+
+// Scenario files describe a world's catalogs and starting factories, as an alternative
+// to the random generator in initializeSimulation. One record per line, fields separated
+// by commas, the first field naming the record type. Blank lines and lines starting with
+// '#' are ignored. Prices and balances are decimal currency amounts (e.g. 12.50) and are
+// converted to ticks exactly. Names cannot contain commas.
+//
+//   resource,ID,NAME,PRICE
+//   product,ID,NAME,PRICE
+//   equipment,ID,PRICE,OUTPUT_RATE,OPERATING_COST
+//   recipe,PRODUCT_ID,INPUT_ID,QUANTITY         input: a resource or another product
+//   requires,PRODUCT_ID,EQUIPMENT_ID,QUANTITY
+//   player,ID,BALANCE                           the player's factory (optional, ID > 0)
+//   factory,ID,BALANCE                          an AI factory (ID > 0)
+//   stock,FACTORY_ID,COMMODITY_ID,QUANTITY      starting inventory
+//   owns,FACTORY_ID,EQUIPMENT_ID,COUNT          starting equipment
+//
+// A record may only refer to ids defined on earlier lines, and a product may list each
+// input and each piece of equipment only once.
+
+// Parses a scenario into 'world', which must be freshly constructed. 'seed' seeds the
+// running world's rng (daily supply, outside orders). Returns false on the first error
+// and sets 'error' to "line N: ...".
+bool parseScenario(const char* text, size_t length, unsigned int seed, SimulationWorld& world,
+                   std::string& error);
+
+// Reads a whole file into 'text'.
+bool readScenarioFile(const std::string& path, std::string& text);
+
+// readScenarioFile followed by parseScenario.
+bool loadScenario(const std::string& path, unsigned int seed, SimulationWorld& world, std::string& error);
@@ -0,0 +1,371 @@
+#include "ShardedSimulation.h"
+#include "HistoryStore.h"
+#include "Log.h"
+#include "ResourceMarket.h"
+#include <cerrno>
+#include <cstdint>
+#include <random>
+#include <unordered_set>
+
+#if !defined(_WIN32)
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Coordinator -> worker: start of a day, followed by priceCount Prices (resources, then
+    // products, in catalog order). day 0 tells the worker to exit.
+    struct DayHeader {
+        int32_t day;
+        int32_t priceCount;
+    };
+
+    // Worker -> coordinator: end of its day, followed by commandCount DeferredCommands and
+    // stateCount int64 values describing its factories (see encodeFactory).
+    struct ReportHeader {
+        int64_t commandCount;
+        int64_t stateCount;
+    };
+
+#if !defined(_WIN32)
+#if defined(MSG_NOSIGNAL)
+    const int SEND_FLAGS = MSG_NOSIGNAL;   // A dead peer is an error, not a SIGPIPE.
+#else
+    const int SEND_FLAGS = 0;
+#endif
+
+    bool writeAll(int fd, const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t written = ::send(fd, bytes, size, SEND_FLAGS);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                return false;
+            bytes += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    bool readAll(int fd, void* data, size_t size) {
+        char* bytes = static_cast<char*>(data);
+        while (size > 0) {
+            ssize_t got = ::recv(fd, bytes, size, 0);
+            if (got < 0 && errno == EINTR)
+                continue;
+            if (got <= 0)
+                return false;
+            bytes += got;
+            size -= static_cast<size_t>(got);
+        }
+        return true;
+    }
+#endif
+
+    // index, balance, equipment count, (equipment id, count)..., inventory count,
+    // (commodity id, is product, quantity)...
+    void encodeFactory(const Factory& factory, int index, std::vector<int64_t>& out) {
+        out.push_back(index);
+        out.push_back(factory.balance);
+        out.push_back(static_cast<int64_t>(factory.equipment.size()));
+        for (const auto& holding : factory.equipment) {
+            out.push_back(holding.type.id);
+            out.push_back(holding.count);
+        }
+        out.push_back(static_cast<int64_t>(factory.inventory.size()));
+        for (const auto& item : factory.inventory) {
+            out.push_back(item.first.id);
+            out.push_back(item.first.type == CommodityType::Product ? 1 : 0);
+            out.push_back(item.second);
+        }
+    }
+
+    // Applies a worker's factory records to the coordinator's world. Returns false on a
+    // malformed record.
+    bool decodeFactories(SimulationWorld& world, const std::vector<int64_t>& in) {
+        std::unordered_map<int, const Equipment*> equipment;
+        for (const auto& type : world.equipmentCatalog)
+            equipment[type.id] = &type;
+        std::unordered_map<int, const Commodity*> resources;
+        std::unordered_map<int, const Commodity*> products;
+        for (const auto& res : world.resourceCatalog)
+            resources[res.id] = &res;
+        for (const auto& prod : world.productCatalog)
+            products[prod.id] = &prod;
+
+        size_t at = 0;
+        auto next = [&](int64_t& value) {
+            if (at >= in.size())
+                return false;
+            value = in[at++];
+            return true;
+        };
+        while (at < in.size()) {
+            int64_t index = 0, balance = 0, count = 0;
+            if (!next(index) || !next(balance) || !next(count) ||
+                index < 0 || index >= static_cast<int64_t>(world.aiFactories.size()))
+                return false;
+            Factory& factory = world.aiFactories[index];
+            factory.balance = balance;
+            factory.equipment.write().clear();
+            factory.capacity = 0;
+            factory.operatingCost = 0;
+            for (int64_t i = 0; i < count; i++) {
+                int64_t id = 0, units = 0;
+                if (!next(id) || !next(units))
+                    return false;
+                auto type = equipment.find(static_cast<int>(id));
+                if (type == equipment.end())
+                    return false;
+                factory.addEquipment(*type->second, static_cast<int>(units));
+            }
+            if (!next(count))
+                return false;
+            factory.inventory.write().clear();
+            for (int64_t i = 0; i < count; i++) {
+                int64_t id = 0, isProduct = 0, quantity = 0;
+                if (!next(id) || !next(isProduct) || !next(quantity))
+                    return false;
+                const auto& catalog = isProduct ? products : resources;
+                auto item = catalog.find(static_cast<int>(id));
+                if (item == catalog.end())
+                    return false;
+                factory.inventory.write().push_back({ *item->second, static_cast<int>(quantity) });
+            }
+        }
+        return true;
+    }
+
+#if !defined(_WIN32)
+    // Body of a worker process; never returns. 'world' is the worker's own copy.
+    [[noreturn]] void runWorker(SimulationWorld& world, const AgentMix& mix, int fd, int index, int count,
+                                unsigned int seed) {
+        setLogEnabled(false);
+        std::seed_seq seq{ seed, static_cast<unsigned int>(index) };
+        world.rng.seed(seq);
+        // The coordinator owns the book; this copy only records operations.
+        std::vector<DeferredCommand> commands;
+        world.market.books.clear();
+        world.market.trades.clear();
+        world.market.recountRestingAmounts();
+        world.market.feed = nullptr;
+        world.market.deferred = &commands;
+        AgentPopulation agents(mix);
+        agents.assign(world.aiFactories.size());
+
+        std::vector<Price> prices;
+        std::vector<int64_t> state;
+        size_t resources = world.resourceCatalog.size();
+        while (true) {
+            DayHeader header;
+            if (!readAll(fd, &header, sizeof(header)) || header.day <= 0 ||
+                header.priceCount != static_cast<int32_t>(resources + world.productCatalog.size()))
+                break;
+            prices.resize(header.priceCount);
+            if (!readAll(fd, prices.data(), prices.size() * sizeof(Price)))
+                break;
+            for (size_t i = 0; i < prices.size(); i++) {
+                Commodity& item = i < resources ? world.resourceCatalog[i] : world.productCatalog[i - resources];
+                item.price = prices[i];
+                world.productionGraph.setPrice(item.id, prices[i]);
+            }
+
+            commands.clear();
+            state.clear();
+            for (size_t i = index; i < world.aiFactories.size(); i += count) {
+                agents.act(world, static_cast<int>(i));
+                encodeFactory(world.aiFactories[i], static_cast<int>(i), state);
+            }
+            ReportHeader report = { static_cast<int64_t>(commands.size()), static_cast<int64_t>(state.size()) };
+            if (!writeAll(fd, &report, sizeof(report)) ||
+                !writeAll(fd, commands.data(), commands.size() * sizeof(DeferredCommand)) ||
+                !writeAll(fd, state.data(), state.size() * sizeof(int64_t)))
+                break;
+        }
+        ::close(fd);
+        // Skip static destructors and stdio buffers copied from the parent.
+        _exit(0);
+    }
+#endif
+}
+
+ShardedSimulation::ShardedSimulation(SimulationWorld& world, const AgentMix& mix)
+    : world(world), mix(mix), history(nullptr) {}
+
+ShardedSimulation::~ShardedSimulation() {
+    stop();
+}
+
+bool ShardedSimulation::start(int count) {
+    stop();
+#if defined(_WIN32)
+    (void)count;
+    simLog() << "ShardedSimulation: worker processes are not supported on Windows\n";
+    return false;
+#else
+    if (count <= 0)
+        return false;
+    unsigned int baseSeed = static_cast<unsigned int>(world.rng());
+    for (int index = 0; index < count; index++) {
+        int fds[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            simLog() << "ShardedSimulation: cannot create a socket pair\n";
+            stop();
+            return false;
+        }
+        pid_t pid = ::fork();
+        if (pid < 0) {
+            ::close(fds[0]);
+            ::close(fds[1]);
+            simLog() << "ShardedSimulation: cannot start worker " << index << "\n";
+            stop();
+            return false;
+        }
+        if (pid == 0) {
+            ::close(fds[0]);
+            for (const auto& other : workers)
+                ::close(other.fd);
+            runWorker(world, mix, fds[1], index, count, baseSeed);
+        }
+        ::close(fds[1]);
+        workers.push_back({ static_cast<int>(pid), fds[0], {} });
+    }
+    return true;
+#endif
+}
+
+bool ShardedSimulation::runDay(int day) {
+#if defined(_WIN32)
+    (void)day;
+    return false;
+#else
+    if (workers.empty())
+        return false;
+    std::vector<Price> prices;
+    for (const auto& res : world.resourceCatalog)
+        prices.push_back(res.price);
+    for (const auto& prod : world.productCatalog)
+        prices.push_back(prod.price);
+    DayHeader header = { day, static_cast<int32_t>(prices.size()) };
+
+    // Every worker starts before any report is read, so they run concurrently.
+    bool ok = true;
+    for (const auto& worker : workers) {
+        ok = ok && writeAll(worker.fd, &header, sizeof(header)) &&
+            writeAll(worker.fd, prices.data(), prices.size() * sizeof(Price));
+    }
+    std::vector<std::vector<DeferredCommand>> commands(workers.size());
+    std::vector<std::vector<int64_t>> states(workers.size());
+    for (size_t w = 0; ok && w < workers.size(); w++) {
+        ReportHeader report;
+        ok = readAll(workers[w].fd, &report, sizeof(report)) && report.commandCount >= 0 && report.stateCount >= 0;
+        if (!ok)
+            break;
+        commands[w].resize(static_cast<size_t>(report.commandCount));
+        states[w].resize(static_cast<size_t>(report.stateCount));
+        ok = readAll(workers[w].fd, commands[w].data(), commands[w].size() * sizeof(DeferredCommand)) &&
+            readAll(workers[w].fd, states[w].data(), states[w].size() * sizeof(int64_t));
+    }
+    for (size_t w = 0; ok && w < workers.size(); w++) {
+        applyCommands(workers[w], commands[w]);
+        ok = decodeFactories(world, states[w]);
+    }
+    if (!ok) {
+        simLog() << "ShardedSimulation: lost a worker on day " << day << "\n";
+        stop();
+        return false;
+    }
+    pruneOrderIds();
+
+    updateMarketPrices(world);
+    if (history)
+        history->recordDay(world, day);
+    world.market.trades.clear();
+    return true;
+#endif
+}
+
+void ShardedSimulation::stop() {
+#if !defined(_WIN32)
+    for (const auto& worker : workers) {
+        DayHeader header = { 0, 0 };
+        writeAll(worker.fd, &header, sizeof(header));
+        ::close(worker.fd);
+    }
+    for (const auto& worker : workers) {
+        int status = 0;
+        while (::waitpid(worker.pid, &status, 0) < 0 && errno == EINTR) {
+        }
+    }
+#endif
+    workers.clear();
+}
+
+void ShardedSimulation::applyCommands(Worker& worker, const std::vector<DeferredCommand>& commands) {
+    Market& market = world.market;
+    std::vector<BasketLeg> legs;
+    size_t i = 0;
+    while (i < commands.size()) {
+        const DeferredCommand& command = commands[i];
+        switch (command.kind) {
+        case DeferredKind::Buy:
+            worker.orderIds[command.orderId] =
+                market.placeBuyOrder(command.productId, command.amount, command.price, command.ownerId);
+            break;
+        case DeferredKind::Sell:
+            worker.orderIds[command.orderId] =
+                market.placeSellOrder(command.productId, command.amount, command.price, command.ownerId);
+            break;
+        case DeferredKind::Cancel: {
+            auto it = worker.orderIds.find(command.orderId);
+            if (it != worker.orderIds.end()) {
+                market.removeOrder(it->second, command.ownerId);
+                worker.orderIds.erase(it);
+            }
+            break;
+        }
+        case DeferredKind::Amend: {
+            auto it = worker.orderIds.find(command.orderId);
+            if (it != worker.orderIds.end())
+                market.amendOrder(it->second, command.ownerId, command.amount, command.price);
+            break;
+        }
+        case DeferredKind::BasketAllOrNone:
+        case DeferredKind::BasketProportional: {
+            // A basket is its run of consecutive legs with the same id.
+            legs.clear();
+            size_t end = i;
+            while (end < commands.size() && commands[end].kind == command.kind &&
+                   commands[end].orderId == command.orderId) {
+                legs.push_back({ commands[end].productId, commands[end].amount, commands[end].price, 0 });
+                end++;
+            }
+            BasketFill fill = command.kind == DeferredKind::BasketAllOrNone ? BasketFill::AllOrNone : BasketFill::Proportional;
+            market.placeBasketOrder(legs, fill, command.ownerId);
+            i = end;
+            continue;
+        }
+        }
+        i++;
+    }
+}
+
+void ShardedSimulation::pruneOrderIds() {
+    // Only resting orders can still be cancelled or amended; forget the rest.
+    std::unordered_set<int> resting;
+    for (const auto& entry : world.market.books) {
+        for (const auto& order : entry.second)
+            resting.insert(order.id);
+    }
+    for (auto& worker : workers) {
+        for (auto it = worker.orderIds.begin(); it != worker.orderIds.end();) {
+            if (resting.count(it->second))
+                ++it;
+            else
+                it = worker.orderIds.erase(it);
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include "AgentStrategies.h"
+#include "Initialization.h"
+
+class HistoryWriter;
+
+// Runs the AI factories of one world in several worker processes on this host. The
+// calling process keeps the market: the order book, price engine and history.
+//
+// start() forks the workers, and each one owns the factories whose index % workers is
+// its own. Every day is a barrier:
+// - The coordinator sends the current prices to every worker over a Unix socketpair.
+// - Each worker gives each of its factories one turn. Its Market only records the order
+//   operations (Market::deferred), so nothing is matched in the worker.
+// - Each worker ships its operations and the new state of its factories back in one batch.
+// - The coordinator applies the batches in worker order, which makes a run reproducible
+//   for a given worker count, then runs the end-of-day price update.
+//
+// Compared with EventSimulation, every factory acts once a day in index order and no
+// outside intraday orders are generated. POSIX only; start() fails on Windows.
+class ShardedSimulation {
+public:
+    explicit ShardedSimulation(SimulationWorld& world, const AgentMix& mix = AgentMix());
+    ~ShardedSimulation();
+
+    ShardedSimulation(const ShardedSimulation&) = delete;
+    ShardedSimulation& operator=(const ShardedSimulation&) = delete;
+
+    // Forks 'workers' worker processes. Returns false if any of them cannot be started.
+    bool start(int workers);
+
+    // Runs 'day' (1-based) across the workers. Returns false if a worker has failed; the
+    // simulation is stopped then.
+    bool runDay(int day);
+
+    // Tells the workers to exit and waits for them.
+    void stop();
+
+    int workerCount() const { return static_cast<int>(workers.size()); }
+
+    // Records each day's closing prices, trades and factory state (nullptr = off).
+    void setHistory(HistoryWriter* writer) { history = writer; }
+
+private:
+    struct Worker {
+        int pid;
+        int fd;
+        std::unordered_map<int, int> orderIds;   // Worker-local order id -> book order id.
+    };
+
+    void applyCommands(Worker& worker, const std::vector<DeferredCommand>& commands);
+    void pruneOrderIds();
+
+    SimulationWorld& world;
+    AgentMix mix;
+    std::vector<Worker> workers;
+    HistoryWriter* history;
+};
@@ -1,5 +1,7 @@
 #include "SimplexAlgorithm.h"
-#include <iostream>
+#include "Log.h"
+#include "Metrics.h"
+#include "Trace.h"
 #include <iomanip>
 #include <limits>
 
@@ -14,14 +16,15 @@ Simplex::Simplex(const vector<vector<double>>& tableau_init) {
 void Simplex::printTableau() {
     for (size_t i = 0; i < tableau.size(); i++) {
         for (size_t j = 0; j < tableau[i].size(); j++) {
-            cout << setw(10) << tableau[i][j] << " ";
+            simLog() << setw(10) << tableau[i][j] << " ";
         }
-        cout << endl;
+        simLog() << endl;
     }
-    cout << endl;
+    simLog() << endl;
 }
 
 void Simplex::pivot(int pivotRow, int pivotCol) {
+    METRICS_COUNT(MetricCounter::LpPivots, 1);
     double pivotVal = tableau[pivotRow][pivotCol];
     // Normalize the pivot row so that the pivot element becomes 1.
     for (size_t j = 0; j < tableau[pivotRow].size(); j++) {
@@ -39,6 +42,13 @@ void Simplex::pivot(int pivotRow, int pivotCol) {
 }
 
 bool Simplex::solve() {
+    return solve(chrono::steady_clock::time_point::max()) == SolveStatus::Optimal;
+}
+
+SolveStatus Simplex::solve(chrono::steady_clock::time_point deadline) {
+    METRICS_TIME(MetricPhase::LpSolve);
+    TRACE_SCOPE("Simplex::solve");
+    bool bounded = deadline != chrono::steady_clock::time_point::max();
     while (true) {
         // Find the entering variable: the most negative coefficient in the objective row.
         int pivotCol = -1;
@@ -67,14 +77,17 @@ bool Simplex::solve() {
         }
         // If no valid pivot row is found, the problem is unbounded.
         if (pivotRow == -1) {
-            cout << "The problem is unbounded." << endl;
-            return false;
+            simLog() << "The problem is unbounded." << endl;
+            return SolveStatus::Unbounded;
         }
 
+        if (bounded && chrono::steady_clock::now() >= deadline)
+            return SolveStatus::TimedOut;
+
         // Perform the pivot operation.
         pivot(pivotRow, pivotCol);
     }
-    return true;
+    return SolveStatus::Optimal;
 }
 
 vector<double> Simplex::getSolution() {
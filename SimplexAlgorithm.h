@@ -1,6 +1,9 @@
 #pragma once
+#include <chrono>
 #include <vector>
 
+enum class SolveStatus { Optimal, Unbounded, TimedOut };
+
 class Simplex {
 private:
     int m; // Number of constraints (excluding the objective row)
@@ -23,6 +26,10 @@ public:
     // Returns true if an optimal solution is found, or false if the problem is unbounded.
     bool solve();
 
+    // Runs the simplex algorithm until it is optimal, unbounded or 'deadline' has passed
+    // (checked before each pivot). On TimedOut the tableau holds the pivots made so far.
+    SolveStatus solve(std::chrono::steady_clock::time_point deadline);
+
     // Retrieves the optimal solution (values for decision variables).
     // Non-basic variables are set to zero.
     std::vector<double> getSolution();
@@ -0,0 +1,148 @@
+#include "Simulation.h"
+#include "ResourceMarket.h"
+#include "Metrics.h"
+#include "HistoryStore.h"
+#include <algorithm>
+
+namespace {
+    const int DIP_TRADER_LOT = 10;
+    const int DIP_TRADER_PERCENT = 5;   // Dip to buy at and markup to sell at.
+}
+
+EventSimulation::EventSimulation(SimulationWorld& world, AgentPopulation& agents,
+                                 const IntradayConfig& config)
+    : world(world), agents(agents), config(config), coroutines(world),
+      idleDays(world.aiFactories.size(), 0), history(nullptr) {
+    agents.assign(world.aiFactories.size());
+    agents.lpController().setPlanningBudget(config.planning);
+    SimTime start = events.now();
+
+    // AI factories wake in the first half of the day, spread evenly and in catalog order.
+    int factoryCount = static_cast<int>(world.aiFactories.size());
+    for (int i = 0; i < factoryCount; i++) {
+        SimEvent wakeup{};
+        wakeup.time = start + (i + 1) * (TICKS_PER_DAY / 2) / (factoryCount + 1);
+        wakeup.type = EventType::AgentWakeup;
+        wakeup.target = i;
+        events.schedule(wakeup);
+    }
+
+    // The price update is the last event of each day.
+    SimEvent close{};
+    close.time = start + TICKS_PER_DAY - 1;
+    close.type = EventType::PriceUpdate;
+    events.schedule(close);
+
+    if (config.orderArrivalsPerDay > 0) {
+        for (const auto& res : world.resourceCatalog)
+            scheduleArrival(res, start);
+    }
+
+    if (!world.resourceCatalog.empty()) {
+        for (int i = 0; i < config.dipTraders; i++) {
+            const Commodity& res = world.resourceCatalog[i % world.resourceCatalog.size()];
+            coroutines.spawn(dipTrader(coroutines, DIP_TRADER_ID, res.id, DIP_TRADER_LOT,
+                                       DIP_TRADER_PERCENT, DIP_TRADER_PERCENT));
+        }
+    }
+}
+
+void EventSimulation::runDay(int day) {
+    runUntil(day * TICKS_PER_DAY - 1);
+}
+
+void EventSimulation::runUntil(SimTime end) {
+    SimEvent event;
+    while (events.popNext(end, event))
+        handle(event);
+    events.advanceTo(end);
+}
+
+void EventSimulation::handle(const SimEvent& event) {
+    METRICS_COUNT(MetricCounter::Events, 1);
+    switch (event.type) {
+    case EventType::OrderArrival:
+        arriveOrder(event);
+        break;
+    case EventType::OrderExpiry:
+        // Already filled orders are gone from the book; removeOrder just reports that.
+        world.market.removeOrder(event.target, event.ownerId);
+        break;
+    case EventType::AgentWakeup:
+        wakeAgent(event);
+        break;
+    case EventType::PriceUpdate: {
+        updateMarketPrices(world);
+        if (history)
+            history->recordDay(world, static_cast<int>(event.time / TICKS_PER_DAY) + 1);
+        // The day's trade records are only kept for the history; don't let them accumulate.
+        world.market.trades.clear();
+        coroutines.closeDay();
+        agents.lpController().beginDay();
+        SimEvent next = event;
+        next.time += TICKS_PER_DAY;
+        events.schedule(next);
+        break;
+    }
+    }
+    coroutines.runReady();
+}
+
+void EventSimulation::wakeAgent(const SimEvent& event) {
+    Factory& factory = world.aiFactories[event.target];
+    Price balanceBefore = factory.balance;
+    int capacityBefore = factory.capacity;
+    int nextOrderIdBefore = world.market.nextOrderId;
+
+    agents.act(world, event.target);
+
+    bool acted = factory.balance != balanceBefore || factory.capacity != capacityBefore ||
+        world.market.nextOrderId != nextOrderIdBefore;
+    int& idle = idleDays[event.target];
+    idle = acted ? 1 : std::min(std::max(1, idle * 2), config.maxIdleDays);
+
+    SimEvent next = event;
+    next.time += idle * TICKS_PER_DAY;
+    events.schedule(next);
+}
+
+void EventSimulation::arriveOrder(const SimEvent& event) {
+    int orderId = event.side == OrderType::BUY
+        ? world.market.placeBuyOrder(event.target, event.amount, event.price, event.ownerId)
+        : world.market.placeSellOrder(event.target, event.amount, event.price, event.ownerId);
+
+    SimEvent expiry{};
+    expiry.time = event.time + config.orderLifetime;
+    expiry.type = EventType::OrderExpiry;
+    expiry.target = orderId;
+    expiry.ownerId = event.ownerId;
+    events.schedule(expiry);
+
+    // Outside traders are the only source of generated arrivals; keep each resource's stream going.
+    if (event.ownerId == OUTSIDE_TRADER_ID && config.orderArrivalsPerDay > 0) {
+        for (const auto& res : world.resourceCatalog) {
+            if (res.id == event.target) {
+                scheduleArrival(res, event.time);
+                break;
+            }
+        }
+    }
+}
+
+void EventSimulation::scheduleArrival(const Commodity& resource, SimTime after) {
+    // Poisson arrivals; each order is priced within 5% of the resource's current price.
+    std::exponential_distribution<double> gap(static_cast<double>(config.orderArrivalsPerDay) / TICKS_PER_DAY);
+    std::uniform_int_distribution<int> side(0, 1);
+    std::uniform_int_distribution<int> amount(1, 50);
+    std::uniform_int_distribution<int> spreadPermille(950, 1050);
+
+    SimEvent arrival{};
+    arrival.time = after + 1 + static_cast<SimTime>(gap(world.rng));
+    arrival.type = EventType::OrderArrival;
+    arrival.target = resource.id;
+    arrival.side = side(world.rng) ? OrderType::BUY : OrderType::SELL;
+    arrival.amount = amount(world.rng);
+    arrival.price = scalePrice(resource.price, spreadPermille(world.rng), 1000);
+    arrival.ownerId = OUTSIDE_TRADER_ID;
+    events.schedule(arrival);
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <random>
+#include <vector>
+#include "Initialization.h"
+#include "AgentStrategies.h"
+#include "AgentCoroutines.h"
+#include "EventScheduler.h"
+
+class HistoryWriter;
+
+// Owner id of orders from the simulated outside traders (0 is the market's own supply).
+constexpr int OUTSIDE_TRADER_ID = -1;
+// Owner id of the coroutine dip traders (see dipTrader).
+constexpr int DIP_TRADER_ID = -2;
+
+struct IntradayConfig {
+    int orderArrivalsPerDay = 0;               // Outside orders per resource per day (Poisson); 0 = none.
+    SimTime orderLifetime = TICKS_PER_DAY / 8; // Unfilled outside orders are cancelled after this long.
+    int maxIdleDays = 8;                       // Longest sleep of an AI factory whose turns change nothing.
+    int dipTraders = 0;                        // Coroutine dip traders, spread over the resources.
+    PlanningBudget planning;                   // LP planning time limits of the AI factories.
+};
+
+// Drives the non-interactive part of the world from an event queue instead of a fixed
+// per-day sweep. AI factories wake at staggered times of day and reschedule themselves:
+// a factory whose turn changed nothing (no orders, purchases or balance change) sleeps
+// twice as long each time, up to maxIdleDays, so idle factories cost almost nothing.
+// Outside traders add intraday order flow, and the resource price update closes each day.
+// Coroutine agents (AgentCoroutines.h) are resumed after the event that woke them.
+class EventSimulation {
+public:
+    // Factories without a behaviour in 'agents' are given one from its mix.
+    EventSimulation(SimulationWorld& world, AgentPopulation& agents,
+                    const IntradayConfig& config = IntradayConfig());
+
+    // Handles every event of 'day' (1-based). The interactive game runs the player's turn
+    // before each call; headless runs call it on its own.
+    void runDay(int day);
+
+    // Handles every event due at or before 'end'.
+    void runUntil(SimTime end);
+
+    // For injecting extra events (e.g. scripted orders) and reading the clock.
+    EventScheduler& scheduler() { return events; }
+
+    // For spawning coroutine agents; they share the world's market.
+    AgentScheduler& coroutineAgents() { return coroutines; }
+
+    // Records each day's closing prices, trades and factory state (nullptr = off).
+    void setHistory(HistoryWriter* writer) { history = writer; }
+
+private:
+    void handle(const SimEvent& event);
+    void wakeAgent(const SimEvent& event);
+    void arriveOrder(const SimEvent& event);
+    void scheduleArrival(const Commodity& resource, SimTime after);
+
+    SimulationWorld& world;
+    AgentPopulation& agents;
+    IntradayConfig config;
+    EventScheduler events;
+    AgentScheduler coroutines;
+    std::vector<int> idleDays;  // Per AI factory: days slept before the current wakeup.
+    HistoryWriter* history;
+};
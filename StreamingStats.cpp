@@ -0,0 +1,119 @@
+#include "StreamingStats.h"
+#include <algorithm>
+#include <cmath>
+
+void RunningStats::add(double x) {
+    if (n == 0) {
+        lo = hi = x;
+    }
+    else {
+        lo = std::min(lo, x);
+        hi = std::max(hi, x);
+    }
+    n++;
+    double delta = x - m;
+    m += delta / n;
+    m2 += delta * (x - m);
+}
+
+void RunningStats::merge(const RunningStats& other) {
+    if (other.n == 0)
+        return;
+    if (n == 0) {
+        *this = other;
+        return;
+    }
+    size_t total = n + other.n;
+    double delta = other.m - m;
+    m2 += other.m2 + delta * delta * (static_cast<double>(n) * other.n / total);
+    m += delta * other.n / total;
+    lo = std::min(lo, other.lo);
+    hi = std::max(hi, other.hi);
+    n = total;
+}
+
+P2Quantile::P2Quantile(double p) : p(p), n(0) {
+    for (int i = 0; i < 5; i++) {
+        heights[i] = 0.0;
+        positions[i] = i + 1;
+    }
+    desired[0] = 1;
+    desired[1] = 1 + 2 * p;
+    desired[2] = 1 + 4 * p;
+    desired[3] = 3 + 2 * p;
+    desired[4] = 5;
+    increments[0] = 0;
+    increments[1] = p / 2;
+    increments[2] = p;
+    increments[3] = (1 + p) / 2;
+    increments[4] = 1;
+}
+
+void P2Quantile::add(double x) {
+    // The first five observations seed the markers directly.
+    if (n < 5) {
+        heights[n++] = x;
+        if (n == 5)
+            std::sort(heights, heights + 5);
+        return;
+    }
+    n++;
+
+    // Find the cell containing x, widening the extremes if needed.
+    int k;
+    if (x < heights[0]) {
+        heights[0] = x;
+        k = 0;
+    }
+    else if (x >= heights[4]) {
+        heights[4] = x;
+        k = 3;
+    }
+    else {
+        k = 0;
+        while (x >= heights[k + 1])
+            k++;
+    }
+    for (int i = k + 1; i < 5; i++)
+        positions[i] += 1;
+    for (int i = 0; i < 5; i++)
+        desired[i] += increments[i];
+
+    // Move the three middle markers towards their desired positions.
+    for (int i = 1; i <= 3; i++) {
+        double d = desired[i] - positions[i];
+        if ((d >= 1 && positions[i + 1] - positions[i] > 1) ||
+            (d <= -1 && positions[i - 1] - positions[i] < -1)) {
+            int step = d > 0 ? 1 : -1;
+            double candidate = parabolic(i, step);
+            if (heights[i - 1] < candidate && candidate < heights[i + 1])
+                heights[i] = candidate;
+            else
+                heights[i] = linear(i, step);
+            positions[i] += step;
+        }
+    }
+}
+
+double P2Quantile::parabolic(int i, int d) const {
+    return heights[i] + d / (positions[i + 1] - positions[i - 1]) *
+        ((positions[i] - positions[i - 1] + d) * (heights[i + 1] - heights[i]) / (positions[i + 1] - positions[i]) +
+         (positions[i + 1] - positions[i] - d) * (heights[i] - heights[i - 1]) / (positions[i] - positions[i - 1]));
+}
+
+double P2Quantile::linear(int i, int d) const {
+    return heights[i] + d * (heights[i + d] - heights[i]) / (positions[i + d] - positions[i]);
+}
+
+double P2Quantile::value() const {
+    if (n == 0)
+        return 0.0;
+    if (n >= 5)
+        return heights[2];
+    // Too few observations for the markers: use the exact nearest-rank quantile.
+    double sorted[5];
+    std::copy(heights, heights + n, sorted);
+    std::sort(sorted, sorted + n);
+    size_t idx = static_cast<size_t>(std::lround(p * (n - 1)));
+    return sorted[idx];
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+
+// Count, mean, variance, min and max of a stream of values in constant memory
+// (Welford's algorithm).
+class RunningStats {
+public:
+    void add(double x);
+    void merge(const RunningStats& other);
+
+    size_t count() const { return n; }
+    double mean() const { return n ? m : 0.0; }
+    double variance() const { return n > 1 ? m2 / (n - 1) : 0.0; }
+    double min() const { return n ? lo : 0.0; }
+    double max() const { return n ? hi : 0.0; }
+
+private:
+    size_t n = 0;
+    double m = 0.0;
+    double m2 = 0.0;
+    double lo = 0.0;
+    double hi = 0.0;
+};
+
+// Estimates one quantile of a stream in constant memory using the P-squared algorithm
+// (Jain & Chlamtac): five markers track the minimum, the target quantile, two
+// intermediate quantiles and the maximum.
+class P2Quantile {
+public:
+    explicit P2Quantile(double p);
+
+    void add(double x);
+    double value() const;
+    size_t count() const { return n; }
+
+private:
+    double parabolic(int i, int d) const;
+    double linear(int i, int d) const;
+
+    double p;
+    size_t n;
+    double heights[5];
+    double positions[5];
+    double desired[5];
+    double increments[5];
+};
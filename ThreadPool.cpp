@@ -0,0 +1,112 @@
+#include "ThreadPool.h"
+
+namespace {
+    // Identifies the pool and worker slot of the current thread, if it is a pool worker.
+    thread_local const ThreadPool* workerPool = nullptr;
+    thread_local int workerIndex = -1;
+}
+
+ThreadPool::ThreadPool(unsigned int threads)
+    : nextQueue(0), stopping(false), pending(0), queued(0) {
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+    for (unsigned int i = 0; i < threads; i++)
+        queues.push_back(std::make_unique<WorkQueue>());
+    for (unsigned int i = 0; i < threads; i++)
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto& worker : workers)
+        worker.join();
+}
+
+int ThreadPool::currentWorker() {
+    return workerIndex;
+}
+
+bool ThreadPool::isOwnWorker() const {
+    return workerPool == this;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    // Workers keep their own follow-up tasks local; outside callers spread the load.
+    unsigned int target = isOwnWorker()
+        ? static_cast<unsigned int>(workerIndex)
+        : nextQueue.fetch_add(1, std::memory_order_relaxed) % size();
+    // Count the task before it becomes visible, so a worker can never finish it first.
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        pending++;
+        queued++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    workAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    allDone.wait(lock, [this] { return pending == 0; });
+}
+
+bool ThreadPool::popLocal(unsigned int index, std::function<void()>& task) {
+    WorkQueue& queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+        return false;
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(unsigned int thief, std::function<void()>& task) {
+    for (unsigned int offset = 1; offset < size(); offset++) {
+        WorkQueue& victim = *queues[(thief + offset) % size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(unsigned int index) {
+    workerPool = this;
+    workerIndex = static_cast<int>(index);
+    while (true) {
+        std::function<void()> task;
+        if (popLocal(index, task) || steal(index, task)) {
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                queued--;
+            }
+            task();
+            bool finished;
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                finished = (--pending == 0);
+            }
+            if (finished)
+                allDone.notify_all();
+            continue;
+        }
+        // Nothing to run or steal: sleep until a task is queued or the pool shuts down.
+        std::unique_lock<std::mutex> lock(stateMutex);
+        workAvailable.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0)
+            return;
+    }
+}
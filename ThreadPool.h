@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size work-stealing thread pool. Each worker owns a task deque: it pops its own
+// newest task first and, when its deque is empty, steals the oldest task from another
+// worker. Tasks submitted from outside the pool are spread round-robin over the workers.
+class ThreadPool {
+public:
+    // 'threads' == 0 uses std::thread::hardware_concurrency().
+    explicit ThreadPool(unsigned int threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+
+    // Blocks until every submitted task has finished.
+    void wait();
+
+    unsigned int size() const { return static_cast<unsigned int>(workers.size()); }
+
+    // Index of the calling worker thread, or -1 if called from outside the pool.
+    static int currentWorker();
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool isOwnWorker() const;
+    void workerLoop(unsigned int index);
+    bool popLocal(unsigned int index, std::function<void()>& task);
+    bool steal(unsigned int thief, std::function<void()>& task);
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<unsigned int> nextQueue;
+    std::atomic<bool> stopping;
+
+    // Wakes idle workers and waiters; 'pending' counts submitted tasks not yet finished.
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    size_t pending;
+    size_t queued;
+};
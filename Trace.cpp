@@ -0,0 +1,144 @@
+#include "Trace.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+    // Upper bound on buffered events per thread (about 40 MB), so a forgotten trace
+    // cannot exhaust memory on a long run.
+    const size_t MAX_EVENTS_PER_THREAD = 1 << 20;
+
+    struct ThreadTraceBuffer {
+        int threadId;
+        std::string threadName;
+        std::vector<TraceEvent> events;
+        size_t openScopes = 0;   // Begins whose end is still to come; room is kept for them.
+        uint64_t dropped = 0;
+    };
+
+    std::atomic<bool> tracingEnabled(false);
+    std::mutex buffersMutex;
+    int nextThreadId = 1;
+
+    // Buffers outlive their threads so that events from finished threads can still be written.
+    std::vector<std::unique_ptr<ThreadTraceBuffer>>& allBuffers() {
+        static std::vector<std::unique_ptr<ThreadTraceBuffer>> buffers;
+        return buffers;
+    }
+
+    ThreadTraceBuffer& localBuffer() {
+        thread_local ThreadTraceBuffer* buffer = nullptr;
+        if (!buffer) {
+            std::lock_guard<std::mutex> lock(buffersMutex);
+            allBuffers().push_back(std::make_unique<ThreadTraceBuffer>());
+            buffer = allBuffers().back().get();
+            buffer->threadId = nextThreadId++;
+            buffer->events.reserve(4096);
+        }
+        return *buffer;
+    }
+
+    int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+
+    void writeEscaped(std::ostream& out, const std::string& text) {
+        for (char c : text) {
+            if (c == '"' || c == '\\')
+                out << '\\';
+            out << c;
+        }
+    }
+}
+
+void Tracer::start() {
+    tracingEnabled.store(true, std::memory_order_release);
+}
+
+void Tracer::stop() {
+    tracingEnabled.store(false, std::memory_order_release);
+}
+
+bool Tracer::isEnabled() {
+    return tracingEnabled.load(std::memory_order_relaxed);
+}
+
+bool Tracer::begin(const char* name, const char* argName, int64_t argValue) {
+    // The cap is checked here only: a begin is kept if there is room for it, its end and
+    // the ends of the scopes already open, so every slice in the file is balanced.
+    ThreadTraceBuffer& buffer = localBuffer();
+    if (buffer.events.size() + buffer.openScopes + 2 > MAX_EVENTS_PER_THREAD) {
+        buffer.dropped += 2;
+        return false;
+    }
+    buffer.events.push_back({ name, 'B', nowNs(), argName, argValue });
+    buffer.openScopes++;
+    return true;
+}
+
+void Tracer::end(const char* name) {
+    ThreadTraceBuffer& buffer = localBuffer();
+    buffer.events.push_back({ name, 'E', nowNs(), nullptr, 0 });
+    if (buffer.openScopes > 0)
+        buffer.openScopes--;
+}
+
+void Tracer::setThreadName(const std::string& name) {
+    localBuffer().threadName = name;
+}
+
+uint64_t Tracer::droppedEvents() {
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    uint64_t dropped = 0;
+    for (const auto& buffer : allBuffers())
+        dropped += buffer->dropped;
+    return dropped;
+}
+
+bool Tracer::writeJson(const std::string& path) {
+    std::ofstream out(path);
+    if (!out)
+        return false;
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    // Timestamps are written relative to the earliest event, in microseconds.
+    int64_t origin = INT64_MAX;
+    for (const auto& buffer : allBuffers()) {
+        if (!buffer->events.empty() && buffer->events.front().timestampNs < origin)
+            origin = buffer->events.front().timestampNs;
+    }
+    if (origin == INT64_MAX)
+        origin = 0;
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first = true;
+    out << std::fixed << std::setprecision(3);
+    for (const auto& buffer : allBuffers()) {
+        if (!buffer->threadName.empty()) {
+            out << (first ? "" : ",\n")
+                << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId
+                << ",\"args\":{\"name\":\"";
+            writeEscaped(out, buffer->threadName);
+            out << "\"}}";
+            first = false;
+        }
+        for (const TraceEvent& event : buffer->events) {
+            out << (first ? "" : ",\n")
+                << "{\"name\":\"" << event.name << "\",\"ph\":\"" << event.phase
+                << "\",\"ts\":" << (event.timestampNs - origin) / 1000.0
+                << ",\"pid\":1,\"tid\":" << buffer->threadId;
+            if (event.argName)
+                out << ",\"args\":{\"" << event.argName << "\":" << event.argValue << "}";
+            out << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Compile-time switch for the tracer. With MARKET_SIM_TRACING set to 0 the TRACE_* macros
+// expand to nothing. When compiled in, tracing still costs only a flag check until
+// Tracer::start() is called.
+#ifndef MARKET_SIM_TRACING
+#define MARKET_SIM_TRACING 1
+#endif
+
+// One begin ('B') or end ('E') record in a thread's trace buffer.
+struct TraceEvent {
+    const char* name;     // Must point at a string literal (or other static storage).
+    char phase;
+    int64_t timestampNs;
+    const char* argName;  // Optional single numeric argument shown in the viewer; may be null.
+    int64_t argValue;
+};
+
+// Scoped begin/end event recorder producing Chrome trace-event JSON, which can be opened
+// in chrome://tracing or ui.perfetto.dev. Each thread appends to its own buffer, so
+// recording takes no locks.
+class Tracer {
+public:
+    // Starts recording on all threads.
+    static void start();
+    // Stops recording; buffered events are kept until written.
+    static void stop();
+    static bool isEnabled();
+
+    // Records a begin event and returns true, or returns false if the thread's buffer has
+    // no room left for it and its end. Call end() exactly once after each true begin().
+    static bool begin(const char* name, const char* argName = nullptr, int64_t argValue = 0);
+    static void end(const char* name);
+
+    // Names the calling thread in the timeline.
+    static void setThreadName(const std::string& name);
+
+    // Writes every thread's events as trace-event JSON. Call it once the traced threads
+    // have finished (or are idle). Returns false if the file cannot be written.
+    static bool writeJson(const std::string& path);
+
+    // Events discarded because a thread's buffer was full.
+    static uint64_t droppedEvents();
+};
+
+// Emits a begin event on construction and the matching end event on destruction.
+class ScopedTrace {
+public:
+    explicit ScopedTrace(const char* name, const char* argName = nullptr, int64_t argValue = 0)
+        : name(name), active(Tracer::isEnabled() && Tracer::begin(name, argName, argValue)) {}
+    ~ScopedTrace() {
+        if (active)
+            Tracer::end(name);
+    }
+    ScopedTrace(const ScopedTrace&) = delete;
+    ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+private:
+    const char* name;
+    bool active;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#if MARKET_SIM_TRACING
+#define TRACE_SCOPE(name) ScopedTrace TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define TRACE_SCOPE_ARG(name, argName, argValue) \
+    ScopedTrace TRACE_CONCAT(traceScope_, __LINE__)(name, argName, argValue)
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_SCOPE_ARG(name, argName, argValue) ((void)0)
+#endif
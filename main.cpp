@@ -1,36 +1,202 @@
+#include <chrono>
 #include <iostream>
+#include <string>
+#include <cstdlib>
 #include "Initialization.h"
 #include "PlayerController.h"
-#include "AIController.h"
-#include "ResourceMarket.h"  // For updateResourcePrices()
+#include "AgentStrategies.h"
+#include "Simulation.h"     // For EventSimulation
+#include "Ensemble.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "MarketDataFeed.h"
+#include "HistoryStore.h"
+#include "Scenario.h"
+#include "ShardedSimulation.h"
+#include "Log.h"
 
-int main() {
-    // Initialize the simulation world.
-    SimulationWorld world = initializeSimulation();
+int main(int argc, char** argv) {
+    // Optional per-day statistics dump: --stats-csv FILE and/or --stats-json FILE.
+    // Optional timeline: --trace FILE writes Chrome trace-event JSON when the simulation ends.
+    // Batch mode: --ensemble RUNS [--days N] [--seed S] [--threads T] [--ensemble-csv FILE]
+    // runs many seeded worlds without the player and prints their aggregated statistics.
+    // --intraday-orders N adds N outside orders per resource per day to the event queue.
+    // --plan-budget-us N and --plan-day-budget-ms N cap the AI factories' LP planning time per
+    // factory and per day; a factory out of time acts on a heuristic plan.
+    // --dip-traders N adds N coroutine dip traders spread over the resources (AgentCoroutines.h).
+    // --feed NAME publishes the order book and prices to shared memory (see market_feed_reader).
+    // --scenario FILE builds the world (or every ensemble world) from a scenario file.
+    // --history DIR appends each day's prices, trades and factory state to a column store.
+    // --agent-mix LP,GREEDY,MAKER,RANDOM sets the share of each AI behaviour (default 1,0,0,0).
+    // --workers N [--days N] [--seed S] runs one world without the player, its AI factories
+    // split across N worker processes (ShardedSimulation.h).
+    DailyStatsWriter statsWriter;
+    std::string tracePath;
+    EnsembleConfig ensembleConfig;
+    ensembleConfig.runs = 0;
+    std::string ensembleCsvPath;
+    std::string feedName;
+    std::string historyDir;
+    std::string scenarioPath;
+    int workers = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        bool opened = true;
+        if (arg == "--stats-csv")
+            opened = statsWriter.openCsv(argv[i + 1]);
+        else if (arg == "--stats-json")
+            opened = statsWriter.openJson(argv[i + 1]);
+        else if (arg == "--trace")
+            tracePath = argv[i + 1];
+        else if (arg == "--ensemble")
+            ensembleConfig.runs = std::atoi(argv[i + 1]);
+        else if (arg == "--days")
+            ensembleConfig.days = std::atoi(argv[i + 1]);
+        else if (arg == "--seed")
+            ensembleConfig.baseSeed = static_cast<unsigned int>(std::strtoul(argv[i + 1], nullptr, 10));
+        else if (arg == "--threads")
+            ensembleConfig.threads = static_cast<unsigned int>(std::strtoul(argv[i + 1], nullptr, 10));
+        else if (arg == "--ensemble-csv")
+            ensembleCsvPath = argv[i + 1];
+        else if (arg == "--feed")
+            feedName = argv[i + 1];
+        else if (arg == "--scenario")
+            scenarioPath = argv[i + 1];
+        else if (arg == "--history")
+            historyDir = argv[i + 1];
+        else if (arg == "--agent-mix") {
+            if (!parseAgentMix(argv[i + 1], ensembleConfig.agentMix)) {
+                std::cout << "Invalid agent mix " << argv[i + 1] << "\n";
+                return 1;
+            }
+        }
+        else if (arg == "--workers")
+            workers = std::atoi(argv[i + 1]);
+        else if (arg == "--intraday-orders")
+            ensembleConfig.intraday.orderArrivalsPerDay = std::atoi(argv[i + 1]);
+        else if (arg == "--plan-budget-us")
+            ensembleConfig.intraday.planning.perFactory = std::chrono::microseconds(std::atoll(argv[i + 1]));
+        else if (arg == "--plan-day-budget-ms")
+            ensembleConfig.intraday.planning.perDay = std::chrono::milliseconds(std::atoll(argv[i + 1]));
+        else if (arg == "--dip-traders")
+            ensembleConfig.intraday.dipTraders = std::atoi(argv[i + 1]);
+        else
+            std::cout << "Ignoring unknown option " << arg << "\n";
+        if (!opened)
+            std::cout << "Cannot open " << argv[i + 1] << " for writing.\n";
+    }
+    if (statsWriter.isOpen() && !MARKET_SIM_METRICS)
+        std::cout << "Metrics are compiled out (MARKET_SIM_METRICS=0); the stats dump will be empty.\n";
+    if (!tracePath.empty()) {
+        Tracer::setThreadName("simulation");
+        Tracer::start();
+    }
+
+    // Check the scenario once up front; ensemble runs re-parse the text for every world.
+    SimulationWorld world;
+    if (!scenarioPath.empty()) {
+        std::string error;
+        if (!readScenarioFile(scenarioPath, ensembleConfig.scenarioText)) {
+            std::cout << "Cannot read scenario " << scenarioPath << "\n";
+            return 1;
+        }
+        if (!parseScenario(ensembleConfig.scenarioText.data(), ensembleConfig.scenarioText.size(),
+                           ensembleConfig.baseSeed, world, error)) {
+            std::cout << "Invalid scenario " << scenarioPath << ": " << error << "\n";
+            return 1;
+        }
+    }
+    else if (workers > 0) {
+        world = initializeSimulation(ensembleConfig.baseSeed);
+    }
+    else if (ensembleConfig.runs == 0) {
+        world = initializeSimulation();
+    }
+
+    if (ensembleConfig.runs > 0) {
+        EnsembleResults results = runEnsemble(ensembleConfig);
+        printEnsembleSummary(results, std::cout);
+        if (!ensembleCsvPath.empty() && !writeEnsembleCsv(results, ensembleCsvPath))
+            std::cout << "Cannot write " << ensembleCsvPath << "\n";
+        if (!tracePath.empty()) {
+            Tracer::stop();
+            Tracer::writeJson(tracePath);
+        }
+        return results.failedRuns > 0 ? 1 : 0;
+    }
+
+    if (workers > 0) {
+        setLogEnabled(false);
+        ShardedSimulation sharded(world, ensembleConfig.agentMix);
+        HistoryWriter history;
+        if (!historyDir.empty()) {
+            if (history.open(historyDir))
+                sharded.setHistory(&history);
+            else
+                std::cout << "Cannot open history store " << historyDir << "\n";
+        }
+        if (!sharded.start(workers)) {
+            std::cout << "Cannot start " << workers << " worker processes.\n";
+            return 1;
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (int day = 1; day <= ensembleConfig.days; day++) {
+            if (!sharded.runDay(day)) {
+                std::cout << "A worker process failed on day " << day << ".\n";
+                return 1;
+            }
+            std::cout << "Day " << day << ": " << world.market.orderCount() << " resting orders\n";
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Elapsed: " << elapsed << " s (" << world.aiFactories.size() << " AI factories, "
+            << (elapsed > 0 ? world.aiFactories.size() * ensembleConfig.days / elapsed : 0.0)
+            << " factory-days/s)\n";
+        return 0;
+    }
+
+    MarketDataFeed feed;
+    if (!feedName.empty()) {
+        if (feed.create(feedName, maxCommodityId(world) + 1))
+            world.market.feed = &feed;
+        else
+            std::cout << "Cannot create market data feed " << feedName << "\n";
+    }
 
     // Create controllers.
     PlayerController playerController;
-    AIController aiController;
+    AgentPopulation agents(ensembleConfig.agentMix);
+    EventSimulation simulation(world, agents, ensembleConfig.intraday);
+    HistoryWriter history;
+    if (!historyDir.empty()) {
+        if (history.open(historyDir))
+            simulation.setHistory(&history);
+        else
+            std::cout << "Cannot open history store " << historyDir << "\n";
+    }
 
     int day = 1;
     char cont;
     while (true) {
         std::cout << "\n===== Day " << day << " =====\n";
+        {
+            TRACE_SCOPE_ARG("day", "day", day);
 
-        // Process the player-controlled factory turn.
-        playerController.takeTurn(world);
+            // Process the player-controlled factory turn.
+            {
+                TRACE_SCOPE("PlayerController::takeTurn");
+                playerController.takeTurn(world);
+            }
 
-        // Process each AI-controlled factory turn.
-        for (auto& aiFactory : world.aiFactories) {
-            aiController.updateFactory(world, aiFactory);
+            // AI wakeups, intraday orders and the closing price update.
+            simulation.runDay(day);
         }
 
-        // Update market prices and (if needed) clear or match orders.
-        updateResourcePrices(world);
-
         // Optionally, clear old orders here or run additional market clearing logic.
         // For example: world.market.clearOrders();
 
+        if (statsWriter.isOpen())
+            statsWriter.recordDay(day);
+
         day++;
         std::cout << "\nProceed to next day? (y/n): ";
         std::cin >> cont;
@@ -39,5 +205,12 @@ int main() {
     }
 
     std::cout << "\nSimulation ended.\n";
+    if (!tracePath.empty()) {
+        Tracer::stop();
+        if (Tracer::writeJson(tracePath))
+            std::cout << "Trace written to " << tracePath << "\n";
+        else
+            std::cout << "Cannot write trace to " << tracePath << "\n";
+    }
     return 0;
 }